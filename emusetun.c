@@ -4,7 +4,7 @@
 * Project: Виртуальная машина МЦВМ "Сетунь" 1958 года на языке Си
 *
 * Create date: 01.11.2018
-* Edit date:   11.02.2021
+* Edit date:   18.10.2026
 *
 * Version: 1.24
 */
@@ -17,6 +17,22 @@
 #include <stdint.h>
 #include <string.h>
 #include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <dirent.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <getopt.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 /** ******************************
  *  Виртуальная машина Сетунь-1958
@@ -119,7 +135,38 @@ enum {
  * Определение памяти машины "Сетунь-1958"
  */ 
 trishort mem_fram[SIZE_PAGE_TRIT_FRAM][SIZE_PAGES_FRAM]; /* оперативное запоминающее устройство на ферритовых сердечниках */
-trishort mem_drum[NUMBER_ZONE_DRUM][SIZE_ZONE_TRIT_DRUM]; /* запоминающее устройство на магнитном барабане */
+trishort drum_store[NUMBER_ZONE_DRUM][SIZE_ZONE_TRIT_DRUM]; /* запоминающее устройство на магнитном барабане */
+
+/**
+ * Зоны магнитного барабана: зона общего образа барабана
+ * или собственная копия зоны машины после первой записи в зону
+ */
+trishort *mem_drum[NUMBER_ZONE_DRUM];
+trishort (*drum_base)[SIZE_ZONE_TRIT_DRUM] = drum_store; /* общий образ барабана */
+uint64_t drum_own[2];		/* зоны с собственной копией */
+uint8_t drum_cow = 0;		/* запись в собственные копии зон */
+
+#define SIZE_DRUM_BYTES	(sizeof(trishort) * SIZE_TRIT_DRUM)			/* размер памяти барабана */
+#define SIZE_ZONE_BYTES	(sizeof(trishort) * SIZE_ZONE_TRIT_DRUM)	/* размер зоны барабана */
+
+/**
+ * Битовые карты изменённых строк FRAM (0...80) и зон DRUM (0...71):
+ * после эталонного сброса и после отметки состояния памяти
+ */
+uint64_t fram_dirty[2];
+uint64_t drum_dirty[2];
+uint64_t fram_mark[2];
+uint64_t drum_mark[2];
+
+#define BITS_SET(m,i)	((m)[(i)>>6] |= (uint64_t)1 << ((i)&63))
+#define BITS_CLR(m,i)	((m)[(i)>>6] &= ~((uint64_t)1 << ((i)&63)))
+#define BITS_GET(m,i)	(((m)[(i)>>6] >> ((i)&63)) & 1)
+
+#define FRAM_TOUCH(i)	do { BITS_SET(fram_dirty,i); BITS_SET(fram_mark,i); } while( 0 )
+#define DRUM_TOUCH(i)	do { BITS_SET(drum_dirty,i); BITS_SET(drum_mark,i); } while( 0 )
+#define BITS_HIGH(n)	(((uint64_t)1 << ((n) - 64)) - 1)	/* биты старшего слова карты для n > 64 элементов */
+#define FRAM_TOUCH_ALL() do { fram_dirty[0] = fram_mark[0] = ~(uint64_t)0; fram_dirty[1] = fram_mark[1] = BITS_HIGH(SIZE_PAGE_TRIT_FRAM); } while( 0 )
+#define DRUM_TOUCH_ALL() do { drum_dirty[0] = drum_mark[0] = ~(uint64_t)0; drum_dirty[1] = drum_mark[1] = BITS_HIGH(NUMBER_ZONE_DRUM); } while( 0 )
 
 /** ***********************************
  *  Определение регистров "Сетунь-1958"
@@ -137,6 +184,21 @@ trs_t MB; /* MB(1:4) троичное число зоны магнитного 
 /* Дополнительные */
 trs_t MR; /* временный регистр для обмена троичным числом */
 
+/* Регистры электрифицированной пишущей машинки */
+uint8_t russian_latin_sw = 0;	/* Регистр переключения Русский/Латинский */
+uint8_t letter_number_sw = 0;	/* Регистр переключения Буквенный/Цифровой */
+uint8_t color_sw = 0;			/* Регистр переключения цвета печатающей ленты */
+
+/* Счетчик выполненных операций машины */
+uint64_t opers_count = 0;
+
+/* Запись временных диаграмм VCD: 1 - операция в окне записи */
+uint8_t vcd_on = 0;
+
+/* Трасса выполнения операций: 0 - без печати */
+uint8_t trace_on = 1;
+#define TRACE(...)	do { if( trace_on ) { printf(__VA_ARGS__); } } while( 0 )
+
 /** --------------------------------------------------
  *  Прототипы функций виртуальной машины "Сетунь-1958"
  *  --------------------------------------------------
@@ -225,6 +287,58 @@ int8_t execute_trs(trs_t addr, trs_t oper);	/* Выполнение кодов 
 void view_short_reg(trs_t *t, uint8_t *ch);
 void view_short_regs(void);
 
+/**
+ * Ожидание обменов устройств с зоной FRAM
+ */
+int8_t io_wait_zone(uint8_t fz);
+
+/**
+ * Барабан в файле
+ */
+int8_t drum_file_open(char *path, uint8_t ro);
+void drum_file_close(void);
+
+/**
+ * Временные диаграммы VCD
+ */
+int8_t vcd_open(char *path);
+void vcd_fram(trs_t ea, trs_t v);
+void vcd_drum(uint8_t zone);
+void vcd_fram_zone(uint8_t fz);
+void vcd_close(void);
+
+/**
+ * Устройства вывода: перфоратор ptp0 и печать lpt0
+ */
+int8_t io_async_start(void);
+void out_flush_all(void);
+void out_close_all(void);
+
+/**
+ * Загрузка программ и бинарный образ машины
+ */
+int8_t load_txs_fram(char *path);
+int8_t load_txs_drum(char *path, trs_t zone);
+int8_t asm_setun(char *path);
+int8_t asm_save_txs(char *path);
+int8_t save_image(char *path);
+int8_t load_image(char *path);
+int8_t checkpoint_setun_1958(char *path);
+int8_t restore_setun_1958(char *path);
+void golden_save(void);
+void golden_reset(void);
+void golden_reset_dirty(void);
+void mem_mark(void);
+uint16_t mem_changed(uint64_t *fram, uint64_t *drum);
+void dump_fram_changed(void);
+void dump_drum_changed(void);
+uint32_t run_setun_1958(uint32_t steps, uint8_t *ret);
+void stat_print(void);
+int8_t stat_json(char *path);
+int8_t prof_folded(char *path);
+int8_t prof_dis(char *path);
+int8_t samp_start(char *path, uint32_t hz);
+
 
 /** ---------------------------------------------------
  *  Реализации функций виртуальной машины "Сетунь-1958"
@@ -469,6 +583,7 @@ trs_t sgn_trs(trs_t x) {
 		} 
 	}
 		
+	clear(&r);
 	r.l = 1;
 	
     if ( sg == 1 ) {
@@ -485,6 +600,38 @@ trs_t sgn_trs(trs_t x) {
 	}
 }
 
+/**
+ * Операция AND trs
+ */
+trs_t and_trs(trs_t x, trs_t y) {
+
+	trs_t r;
+
+	int8_t i,j;
+	int8_t a,b,s;
+
+	if( x.l >= y.l) {
+		j = x.l;
+	}
+	else {
+		j = y.l;
+	}
+
+	r.l = j;
+	r.tb = 0;
+
+	for(i = 0; i < j; i++) {
+		a = trit2bit(x);
+		b = trit2bit(y);
+		and_t(&a, &b, &s);
+		x.tb >>= 2;
+		y.tb >>= 2;
+		r.tb |= (trilong)(bit2tb(s) & 0x03) << (i*2);
+	}
+
+	return r;
+}
+
 /**
  * Операция OR trs
  */
@@ -502,12 +649,16 @@ trs_t or_trs(trs_t x, trs_t y) {
 		j = y.l;
 	}
 			
+	r.l = j;
+	r.tb = 0;
+
 	for(i = 0; i < j; i++) {
-		r.tb <<= 2;
 		a = trit2bit(x);
 		b = trit2bit(y);
-		and_t(&a, &b, &s);
-		r.tb |= bit2tb(s); 		
+		or_t(&a, &b, &s);
+		x.tb >>= 2;
+		y.tb >>= 2;
+		r.tb |= (trilong)(bit2tb(s) & 0x03) << (i*2);
 	}
 
 	return r;	
@@ -529,12 +680,16 @@ trs_t xor_trs(trs_t x, trs_t y) {
 		j = y.l;
 	}
 			
+	r.l = j;
+	r.tb = 0;
+
 	for(i = 0; i < j; i++) {
-		r.tb <<= 2;
 		a = trit2bit(x);
 		b = trit2bit(y);
 		xor_t(&a, &b, &s);
-		r.tb |= bit2tb(s); 		
+		x.tb >>= 2;
+		y.tb >>= 2;
+		r.tb |= (trilong)(bit2tb(s) & 0x03) << (i*2);
 	}
 
 	return r;	
@@ -556,10 +711,10 @@ trs_t not_trs(trs_t x) {
 	}
 
 	for(i = 0; i < r.l; i++) {
-		r.tb <<= 2;
 		s = trit2bit(x);
-		s = -s;				
-		r.tb |= bit2tb(s); 		
+		s = -s;
+		x.tb >>= 2;
+		r.tb |= (trilong)(bit2tb(s) & 0x03) << (i*2);
 	}
 
 	return r;
@@ -908,6 +1063,21 @@ uint8_t row_drum_to_index(trs_t z) {
    return r;
 }
 
+/**
+ * Дешифратор номера зоны MB(1:4) в индекс зоны магнитного барабана
+ * Рез: индекс 0...71 или -1 для номера зоны вне барабана
+ */
+int8_t mb_to_zone_index(trs_t z) {
+
+   int16_t r;
+
+   r = trs_to_digit(&z) + (NUMBER_ZONE_DRUM >> 1);
+   if( r < 0 || r >= NUMBER_ZONE_DRUM ) {
+	   return -1;
+   }
+   return (int8_t)r;
+}
+
 /**
  * Дешифратор трита в индекс адреса памяти FRAM
  */
@@ -991,29 +1161,94 @@ trs_t next_address(trs_t c) {
  * Операция очистить память ферритовую
  */
 void clean_fram(void) {
-	
-	int8_t zone;
-	int8_t row;
+	memset(mem_fram, 0, sizeof(mem_fram));
+	FRAM_TOUCH_ALL();
+}
+
+/**
+ * Освободить собственные копии зон барабана
+ */
+void drum_release(void) {
 
-	for(zone=0; zone < SIZE_PAGES_FRAM; zone++) {
-		for(row=0; row < SIZE_PAGE_TRIT_FRAM; row++) {
-			mem_fram[row][zone] = 0;			
+	uint8_t z;
+
+	for(z=0; z < NUMBER_ZONE_DRUM; z++) {
+		if( BITS_GET(drum_own,z) ) {
+			free(mem_drum[z]);
+			BITS_CLR(drum_own,z);
 		}
-	}	
+		mem_drum[z] = drum_base[z];
+	}
+}
+
+/**
+ * Подключить общий образ барабана
+ *
+ * Пар:  base - зоны барабана
+ *       cow - 1: образ только для чтения, запись в собственные копии зон
+ */
+void drum_bind(trishort (*base)[SIZE_ZONE_TRIT_DRUM], uint8_t cow) {
+
+	drum_release();
+	drum_base = base;
+	drum_cow = cow;
+	drum_release();
+	DRUM_TOUCH_ALL();
+}
+
+/**
+ * Зона барабана для записи.
+ * Для общего образа при первой записи создаётся копия зоны.
+ */
+trishort * drum_zone_wr(uint8_t z) {
+
+	trishort *p;
+
+	if( drum_cow && !BITS_GET(drum_own,z) ) {
+		p = (trishort *)malloc(SIZE_ZONE_BYTES);
+		if( p == NULL ) {
+			printf(" --- ERROR drum zone memory\r\n");
+			exit(1);
+		}
+		memcpy(p, mem_drum[z], SIZE_ZONE_BYTES);
+		mem_drum[z] = p;
+		BITS_SET(drum_own,z);
+	}
+	return mem_drum[z];
+}
+
+/**
+ * Записать зону барабана целиком.
+ * Зона равная общему образу не требует собственной копии.
+ */
+void drum_zone_set(uint8_t z, trishort *src) {
+
+	if( drum_cow && memcmp(drum_base[z], src, SIZE_ZONE_BYTES) == 0 ) {
+		if( BITS_GET(drum_own,z) ) {
+			free(mem_drum[z]);
+			BITS_CLR(drum_own,z);
+		}
+		mem_drum[z] = drum_base[z];
+		return;
+	}
+	memcpy(drum_zone_wr(z), src, SIZE_ZONE_BYTES);
 }
 
 /**
  * Операция очистить память на магнитном барабане
  */
 void clean_drum(void) {
-	int8_t zone;
-	int8_t row;	
 
-	for(zone=0; zone < NUMBER_ZONE_DRUM; zone++) {
-		for(row=0; row < SIZE_ZONE_TRIT_DRUM; row++) {
-			mem_drum[zone][row] = 0;			
-		}
+	uint8_t z;
+
+	if( mem_drum[0] == NULL ) {
+		/* Барабан ещё не подключён */
+		drum_bind(drum_store, 0);
 	}
+	for(z=0; z < NUMBER_ZONE_DRUM; z++) {
+		memset(drum_zone_wr(z), 0, SIZE_ZONE_BYTES);
+	}
+	DRUM_TOUCH_ALL();
 }
 
 #if 0
@@ -1182,6 +1417,10 @@ void st_fram( trs_t ea, trs_t v ) {
 	trs_t zr;
 	trs_t rr;
 
+	if( vcd_on ) {
+		vcd_fram(ea,v);
+	}
+
 	/* Зона физической памяти FRAM */
 	zr = slice_trs(ea,5,5);
 	zr.l = 1;
@@ -1192,6 +1431,8 @@ void st_fram( trs_t ea, trs_t v ) {
 	rr.l = 4;
 	rind = row_fram_to_index(rr);
 
+	FRAM_TOUCH(rind);
+
 	eap5 = get_trit_int(ea,5);	
 	if( eap5 < 0 ) {		
 		/* Записать 18-тритное число */
@@ -1208,1391 +1449,3399 @@ void st_fram( trs_t ea, trs_t v ) {
 	}
 }
 
+/**
+ * Дешифратор адреса A(2:5) в индекс 9-тритного слова в зоне DRUM.
+ * Слова зоны барабана расположены как слова зоны FRAM:
+ * строка A(2:4) и половина строки A(5).
+ */
+uint8_t word_drum_to_index(trs_t ea) {
+
+	uint8_t r = 13;
+
+	r += get_trit_int(ea,4)*1;
+	r += get_trit_int(ea,3)*3;
+	r += get_trit_int(ea,2)*9;
+	r <<= 1;
+	if( get_trit_int(ea,5) > 0 ) {
+		r += 1;
+	}
+	return r;
+}
+
 /**
  * Операция чтения в память магнитного барабана
+ * из зоны MB(1:4) по адресу слова A(2:5)
  */  
 trs_t ld_drum( trs_t ea ) {
-	//TODO
-	uint8_t zind; 
+
+	int8_t zind; 
 	uint8_t rind; 
-	trs_t zr;
-	trs_t rr;
 	trs_t res;
 
-	zr = slice_trs(ea,1,1);	
-	zr.l = 1; 
-	zind = zone_drum_to_index(zr);
-
-	rr = slice_trs(ea,2,5);	
-	rr.l = 4; 
-
 	res.tb = 0;
-	
-	rind = row_fram_to_index(rr);
-	res.tb = mem_drum[zind][rind] & 0x3FFFF;
 	res.l  = 9;
 
+	zind = mb_to_zone_index(MB);
+	if( zind < 0 ) {
+		return res;
+	}
+	rind = word_drum_to_index(ea);
+	res.tb = mem_drum[zind][rind] & 0x3FFFF;
+
 	return res;
 }
 
 /**
  * Операция записи в память магнитного барабана
+ * в зону MB(1:4) по адресу слова A(2:5)
  */
 void st_drum( trs_t ea, trs_t v ) {
-	//TODO
-	uint8_t zind; 
-	uint8_t rind; 
-	trs_t zr;
-	trs_t rr;
 
-	zr.l = 1; 
-	zr = slice_trs(ea,1,1);
-	zind = zone_drum_to_index(zr);
-
-	rr.l = 4; 
-	rr = slice_trs(ea,2,5);	
+	int8_t zind; 
+	uint8_t rind; 
 
-	rind = row_drum_to_index(rr);
-	mem_drum[zind][rind] = v.tb & 0x3FFFF;
+	zind = mb_to_zone_index(MB);
+	if( zind < 0 ) {
+		return;
+	}
+	rind = word_drum_to_index(ea);
+	drum_zone_wr(zind)[rind] = v.tb & 0x3FFFF;
+	DRUM_TOUCH(zind);
 }
 
 /**
  * Операция записи в память магнитного барабана
+ * при загрузке зоны MB(1:4)
  */
 void set_drum( trs_t ea, trs_t v ) {
-	//TODO
-	uint8_t zind; 
-	uint8_t rind; 
-	trs_t zr;
-	trs_t rr;
+	st_drum(ea,v);
+}
 
-	zr.l = 1; 
-	zr = slice_trs(ea,1,1);
-	zind = zone_drum_to_index(zr);
+/** *********************************************
+ *  Счётчики выполнения
+ *  ---------------------------------------------
+ *
+ *  Счётчики машины: операции по коду K(6:8), условные переходы,
+ *  модификации адреса по K(9), переполнения, обмены с барабаном
+ *  и устройствами. Простые приращения в цикле машины, печать
+ *  таблицей или JSON при останове.
+ */
+typedef struct exec_stat {
+	uint64_t op[27];		/* операции по коду K(6:8) + 13 */
+	uint64_t jump_taken;	/* условные переходы выполнены */
+	uint64_t jump_not;		/* условные переходы не выполнены */
+	uint64_t mod_add;		/* K(9) = +: A(1:5) + F(1:5) */
+	uint64_t mod_sub;		/* K(9) = -: A(1:5) - F(1:5) */
+	uint64_t over;			/* остановы по переполнению */
+	uint64_t drum_rd;		/* зоны с барабана в FRAM */
+	uint64_t drum_wr;		/* зоны FRAM на барабан */
+	uint64_t io;			/* обмены устройств операцией -00 */
+} exec_stat_t;
+
+exec_stat_t vm_stat;	/* счётчики машины */
 
-	rr.l = 4; 
-	rr = slice_trs(ea,2,5);	
+/** *********************************************
+ *  Профиль по адресам
+ *  ---------------------------------------------
+ *
+ *  Счётчики выполнения по адресу C: место по полю битов C(1:5)
+ *  без перевода в число (1024 места для 243 адресов).
+ *  Граф переходов: пары (адрес перехода, адрес цели) выполненных
+ *  переходов 000, 0+0, 0++, 0+-. Участок программы начинается с цели
+ *  последнего перехода, пары (участок, адрес) дают свёрнутые стеки.
+ */
+#define PROF_SLOTS		(1024)		/* мест по полю битов C(1:5) */
+#define PROF_PAIRS		(8192)		/* мест в таблицах пар, степень 2 */
+#define PROF_NONE		(0xFFFF)	/* участок не начат */
+
+typedef struct prof_pair {
+	uint32_t key;		/* 1 << 20 | a << 10 | b, 0 - место свободно */
+	uint64_t n;			/* счётчик пары */
+} prof_pair_t;
+
+uint8_t prof_on = 0;					/* 1 - профиль включён */
+uint64_t prof_hits[PROF_SLOTS];			/* операции по адресу */
+static prof_pair_t prof_jumps[PROF_PAIRS];	/* граф переходов */
+static prof_pair_t prof_blocks[PROF_PAIRS];	/* участок и адрес */
+static uint16_t prof_region = PROF_NONE;	/* начало текущего участка */
+uint64_t prof_lost = 0;					/* пары без места в таблице */
 
-	rind = row_drum_to_index(rr);
-	mem_drum[zind][rind] = v.tb & 0x3FFFF;
+/**
+ * Очистить профиль
+ */
+void prof_reset(void) {
+	memset(prof_hits, 0, sizeof(prof_hits));
+	memset(prof_jumps, 0, sizeof(prof_jumps));
+	memset(prof_blocks, 0, sizeof(prof_blocks));
+	prof_region = PROF_NONE;
+	prof_lost = 0;
 }
 
-/** ***********************************************
- *  Алфавит троичной симметричной системы счисления
- *  -----------------------------------------------
- *  Троичный код в девятеричной системы 
- *  -----------------------------------------------
- *  С символами: W, X, Y, Z, 0, 1, 2, 3, 4.
+/**
+ * Прибавить пару (a, b) в таблице t
  */
-uint8_t trit2lt( int8_t v )  {
-	switch( v ) {
-		case -4 : return 'W'; break;
-		case -3 : return 'X'; break;
-		case -2 : return 'Y'; break;
-		case -1 : return 'Z'; break;
-		case  0 : return '0'; break;
-		case  1 : return '1'; break;
-		case  2 : return '2'; break;
-		case  3 : return '3'; break;
-		case  4 : return '4'; break;
-		default : return '0'; break;	
+static inline void prof_add(prof_pair_t *t, uint16_t a, uint16_t b) {
+
+	uint32_t key;
+	uint32_t h;
+	uint16_t n;
+
+	key = (1u << 20) | ((uint32_t)a << 10) | b;
+	h = key * 2654435761u;
+	for(n=0; n<PROF_PAIRS; n++) {
+		h = (h + 1) & (PROF_PAIRS - 1);
+		if( t[h].key == key ) {
+			t[h].n++;
+			return;
+		}
+		if( t[h].key == 0 ) {
+			t[h].key = key;
+			t[h].n = 1;
+			return;
+		}
 	}
+	prof_lost++;
 }
 
 /**
- * Вид '-','0','+' в десятичный код
+ * Операция по адресу c
  */
-int8_t symtrs2numb( uint8_t c )  {
-	switch( c ) {
-		case '-' :
-		 return -1 ; break;
-		case '0' :
-		 return 0; break;
-		case '+' :
-		 return 1; break;
-		default  : return 0; break;	
+static inline void prof_step(trs_t c) {
+
+	uint16_t a;
+
+	a = c.tb & (PROF_SLOTS - 1);
+	if( prof_region == PROF_NONE ) {
+		prof_region = a;
 	}
+	prof_hits[a]++;
+	prof_add(prof_blocks, prof_region, a);
 }
 
 /**
- * Bp  Вид '-','0','+' 
+ * Выполненный переход с адреса c на адрес a
  */
-uint8_t numb2symtrs( int8_t v )  {
-		
-	if( v <= -1 ) {
-		return '-';
-	}
-	else if( v == 0 ) {
-		return '0';
-	}
-	else {
-		return '+';		
-	}
-		
+static inline void prof_jump(trs_t c, trs_t a) {
+	prof_region = a.tb & (PROF_SLOTS - 1);
+	prof_add(prof_jumps, c.tb & (PROF_SLOTS - 1), prof_region);
 }
 
+/** *********************************************
+ *  Гистограммы задержек хоста
+ *  ---------------------------------------------
+ *
+ *  Время хоста в нс складывается в гистограмму с логарифмическими
+ *  промежутками (как HDR): значение до 2^HIST_SUB_BITS - точно,
+ *  дальше каждая степень двойки делится на 2^(HIST_SUB_BITS-1)
+ *  частей, относительная погрешность не более 1/16.
+ *  Время операции машины измеряется у каждой N-й операции,
+ *  обмены с устройствами и барабаном - у каждого обмена.
+ *  Процентили печатаются при останове машины.
+ */
+#define HIST_SUB_BITS	(5)		/* точных значений 2^5 */
+#define HIST_BUCKETS	(1024)	/* промежутков до 2^64 нс */
+#define LAT_EVERY		(64)	/* измерять каждую N-ю операцию */
+
+typedef struct hist {
+	uint64_t count[HIST_BUCKETS];
+	uint64_t n;		/* число значений */
+	uint64_t min;
+	uint64_t max;
+	uint64_t sum;
+} hist_t;
+
+uint8_t lat_on = 0;					/* 1 - гистограммы включены */
+uint32_t lat_every = LAT_EVERY;		/* период измерения операций */
+hist_t lat_step;					/* операция машины */
+hist_t lat_io;						/* обмен с устройствами -00 и их завершение */
+hist_t lat_drum;					/* обмен FRAM с барабаном -0+, -0- */
+
 /**
- *  Вид '-','0','+' строка в десятичный код
+ * Время хоста в нс
  */
-int8_t str_symtrs2numb( uint8_t * s )  {
-	int8_t i;
-	int8_t len;
-	int8_t res = 0;
-	
-	len = strlen(s);
-	
-	for(i=0;i<len;i++) {
-		res += symtrs2numb(s[i]) * pow3(i);
-		printf("%c",s[i]); 
-	}	
-	
-	return res;	
+static inline uint64_t lat_now(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000ull + t.tv_nsec;
 }
 
 /**
- *  Cтроку вида '-','0','+'  в троичное число
+ * Номер промежутка значения v
  */
-trs_t smtr(uint8_t * s) {
+static inline uint32_t hist_index(uint64_t v) {
 
-      int8_t i;
-      int8_t trit;
-      int8_t len,lenmax;
-      trs_t t;
+	uint32_t e;
 
-      len = strlen(s);
-      lenmax = len;
-      t.l = len;
-      
-      if(len > SIZE_WORD_LONG) {
-       t.l = SIZE_WORD_LONG;
-       lenmax = SIZE_WORD_LONG;
-      }
-
-      for(i=0;i<lenmax;i++){
-         trit = symtrs2numb( *(s+(len-i-1)) );
-         set_trit(&t,len-i,trit);
-      }
-      return t;
+	if( v < (1u << HIST_SUB_BITS) ) {
+		return (uint32_t)v;
+	}
+	e = 63 - __builtin_clzll(v) - (HIST_SUB_BITS - 1);
+	return (e << (HIST_SUB_BITS - 1)) + (uint32_t)(v >> e);
 }
 
 /**
- * Девятеричный вид в троичный код
+ * Наименьшее значение промежутка i
  */
-uint8_t * lt2symtrs( int8_t v )  {
-	switch( v ) {
-		case 'W' :
-		case 'w' :
-		 return "--" ; break;
-		case 'X' :
-		case 'x' :
-		 return "-0"; break;
-		case 'Y' :
-		case 'y' :
-		 return "-+"; break;
-		case 'Z' :
-		case 'z' :
-		 return "0-"; break;		
-		case '0' : return "00"; break;
-		case '1' : return "0+"; break;
-		case '2' : return "+-"; break;
-		case '3' : return "+0"; break;
-		case '4' : return "++"; break;
-		default  : return "  "; break;	
+static inline uint64_t hist_low(uint32_t i) {
+
+	uint32_t e;
+
+	if( i < (1u << HIST_SUB_BITS) ) {
+		return i;
 	}
+	e = (i >> (HIST_SUB_BITS - 1)) - 1;
+	return (uint64_t)(i - (e << (HIST_SUB_BITS - 1))) << e;
 }
 
 /**
- *  Троичный код в девятеричной системы 
- *
- *  С символами: W, X, Y, Z, 0, 1, 2, 3, 4. 
+ * Добавить значение v в гистограмму
  */
-uint8_t trit_to_lt( int8_t v )  {
-	switch( v ) {
-		case -4 : return 'W'; break;
-		case -3 : return 'X'; break;
-		case -2 : return 'Y'; break;
-		case -1 : return 'Z'; break;
-		case  0 : return '0'; break;
-		case  1 : return '1'; break;
-		case  2 : return '2'; break;
-		case  3 : return '3'; break;
-		case  4 : return '4'; break;
-		default : return '0'; break;	
+static inline void hist_add(hist_t *h, uint64_t v) {
+	h->count[hist_index(v)]++;
+	if( (h->n == 0) || (v < h->min) ) {
+		h->min = v;
+	}
+	if( v > h->max ) {
+		h->max = v;
 	}
+	h->n++;
+	h->sum += v;
 }
 
 /**
- * Троичный код в девятеричной системы 
- *
+ * Значение процентиля q (0..100): верхняя граница промежутка
  */
-int32_t trs_to_digit( trs_t *tr )  {
+uint64_t hist_value(hist_t *h, double q) {
 
-	int32_t l;    
-    int8_t i;
-    trs_t x;
+	uint64_t target;
+	uint64_t acc;
+	uint32_t i;
+	uint64_t v;
 
-    l = 0;
-    x = *tr;	
-    for( i=0; i<x.l ; i++ ) {		    						
-			x = *tr;
-			x.tb >>= (i*2);		
-			l += trit2bit(x) * pow3(i);
-    }
-    
-	return l;
+	if( h->n == 0 ) {
+		return 0;
+	}
+	target = (uint64_t)(q / 100.0 * h->n);
+	if( (double)target < q / 100.0 * h->n ) {
+		target++;
+	}
+	if( target == 0 ) {
+		target = 1;
+	}
+	acc = 0;
+	for(i=0; i<HIST_BUCKETS; i++) {
+		acc += h->count[i];
+		if( acc >= target ) {
+			v = (i + 1 < HIST_BUCKETS) ? hist_low(i + 1) - 1 : h->max;
+			return (v < h->max) ? v : h->max;
+		}
+	}
+	return h->max;
 }
 
 /**
- * Троичный код в девятеричной системы 
- *
- *  С символами: Ж, Х, У, Ц, 0, 1, 2, 3, 4. 
+ * Очистить гистограммы задержек
  */
-int32_t tb_to_digit( trishort tb )  {
-
-	int32_t l;    
-    int8_t i;
-
-    l = 0;   
-    for( i=0; i<9 ; i++ ) {		    						
-			l += tb2int(tb >> (i*2)) * pow3(i);
-    }
-    
-	return l;
+void lat_reset(void) {
+	memset(&lat_step, 0, sizeof(hist_t));
+	memset(&lat_io, 0, sizeof(hist_t));
+	memset(&lat_drum, 0, sizeof(hist_t));
 }
 
 /**
- * Девятеричный вид в троичный код
+ * Вызов r = expr с измерением времени в гистограмму h
  */
-void cmd_str_2_trs( uint8_t * syms, trs_t * r )  {
-	
-	uint8_t i;
-	uint8_t symtrs_str[40];
+#define LAT_CALL(h, r, expr) do { \
+	if( lat_on ) { \
+		uint64_t lat_t0 = lat_now(); \
+		r = (expr); \
+		hist_add(h, lat_now() - lat_t0); \
+	} \
+	else { \
+		r = (expr); \
+	} \
+} while( 0 )
 
-	if( strlen(syms) != 5) {
-		r->l  = 9;
-		r->tb = 0;
-		printf(" --- ERROR syms\r\n");
-		return;
-	}	
+/**
+ * Печать процентилей гистограмм задержек в нс
+ */
+void lat_print(void) {
 
-	sprintf(symtrs_str,"%2s%2s%2s%2s%2s",
-			lt2symtrs(syms[0]),
-			lt2symtrs(syms[1]),
-			lt2symtrs(syms[2]),
-			lt2symtrs(syms[3]),
-			lt2symtrs(syms[4])			
-		);	
+	static const char *names[] = { "step", "io", "drum" };
+	hist_t *h[] = { &lat_step, &lat_io, &lat_drum };
+	uint8_t i;
 
-	for(i=1;i<10;i++) {
-		set_trit(r,i,symtrs2numb(symtrs_str[i]));		
-	}		
+	printf("\r\n[ Latency Setun-1958, ns, step 1/%u: ]\r\n", lat_every);
+	printf(" hist        count      min      p50      p90      p99    p99.9      max       mean\r\n");
+	for(i=0; i<3; i++) {
+		printf(" %-5s %12llu %8llu %8llu %8llu %8llu %8llu %8llu %10.1f\r\n", names[i],
+			   (unsigned long long)h[i]->n, (unsigned long long)h[i]->min,
+			   (unsigned long long)hist_value(h[i], 50.0), (unsigned long long)hist_value(h[i], 90.0),
+			   (unsigned long long)hist_value(h[i], 99.0), (unsigned long long)hist_value(h[i], 99.9),
+			   (unsigned long long)h[i]->max, h[i]->n ? (double)h[i]->sum / h[i]->n : 0.0);
+	}
 }
 
+/** *********************************************
+ *  Выборочный профиль по сигналу SIGPROF
+ *  ---------------------------------------------
+ *
+ *  Таймер ITIMER_PROF по времени процессора хоста посылает SIGPROF.
+ *  Обработчик сигнала записывает адрес C(1:5), код операции K(6:8)
+ *  и фазу цикла машины в буфер выборок: место берётся атомарным
+ *  приращением счётчика без блокировок. Цикл машины только
+ *  записывает номер фазы. Отчёт пишется при завершении процесса.
+ */
+#define SAMP_MAX		(1 << 20)	/* мест в буфере выборок */
+#define SAMP_HZ			(1000)		/* выборок в секунду по умолчанию */
+
+enum {
+	SAMP_HOST = 0,	/* вне цикла машины */
+	SAMP_FETCH,		/* выборка K из FRAM */
+	SAMP_DECODE,	/* модификация адреса, код операции */
+	SAMP_EXEC,		/* выполнение операции */
+	SAMP_DEVICE,	/* барабан, устройства, события */
+	SAMP_PHASES
+};
+
+typedef struct samp {
+	uint16_t c;		/* поле битов C(1:5) */
+	uint8_t op;		/* код K(6:8) + 13 */
+	uint8_t phase;	/* фаза цикла машины */
+} samp_t;
+
+volatile sig_atomic_t samp_phase = SAMP_HOST;	/* текущая фаза цикла машины */
+static samp_t samp_buf[SAMP_MAX];
+static atomic_uint_fast32_t samp_count;
+static char *samp_path = NULL;
+static uint32_t samp_hz = SAMP_HZ;
+
 /**
- * Печать троичного числа в строку
+ * Обработчик SIGPROF: одна выборка в буфер
  */
-void trit_to_str(trs_t t) {
-	
-	int8_t i,j,n;
-	int8_t t0,t1;
-	trs_t x;
-	
-	n = t.l + 1;
+static void samp_signal(int sig) {
 
-	for (i=0;i<n;i+=2) {
-		x = t;	
-		x.tb >>= (n-2-i)*2 ;
-		t0 = trit2bit(x);
-		x.tb >>= 2;
-		t1 = trit2bit(x);
+	uint32_t i;
 
-		printf("%c",trit_to_lt( t1*3 + t0 ));	
+	(void)sig;
+	i = atomic_fetch_add_explicit(&samp_count, 1, memory_order_relaxed);
+	if( i < SAMP_MAX ) {
+		samp_buf[i].c = C.tb & (PROF_SLOTS - 1);
+		samp_buf[i].op = get_trit_int(K,6) * 9 + get_trit_int(K,7) * 3 + get_trit_int(K,8) + 13;
+		samp_buf[i].phase = samp_phase;
 	}
+}
 
-	return;
+/**
+ * Включить или выключить таймер выборок
+ */
+static void samp_timer(uint32_t hz) {
+
+	struct itimerval it;
+	uint32_t us;
+
+	memset(&it, 0, sizeof(it));
+	if( hz > 0 ) {
+		us = (hz >= 1000000) ? 1 : 1000000 / hz;
+		it.it_interval.tv_sec  = us / 1000000;
+		it.it_interval.tv_usec = us % 1000000;
+		it.it_value = it.it_interval;
+	}
+	setitimer(ITIMER_PROF, &it, NULL);
 }
 
+/** *********************************************
+ *  Время машины и очередь событий
+ *  ---------------------------------------------
+ *
+ *  Время машины cycles считается в тактах 1 мкс.
+ *  События устройств лежат в двоичной куче по времени t,
+ *  при равном времени по номеру id. Цикл машины сравнивает
+ *  cycles с event_next один раз за операцию. Ожидание машины
+ *  пропускает время до следующего события без холостых шагов.
+ */
+#define TIME_OPER			(180)	/* время выполнения операции, такты 1 мкс */
+#define EVENT_NUMBER		(32)	/* мест в очереди событий */
+
+typedef int8_t (*event_fn)(void *ctx);
+
+typedef struct event {
+	uint64_t t;		/* время события */
+	uint8_t id;		/* порядок событий с равным временем */
+	event_fn fn;	/* обработчик события */
+	void *ctx;		/* состояние обработчика */
+} event_t;
+
+uint64_t cycles = 0;					/* время машины в тактах */
+uint64_t event_next = UINT64_MAX;		/* время ближайшего события */
+static event_t event_heap[EVENT_NUMBER];
+static uint8_t event_count = 0;
+
 /**
- * Печать троичного числа в строку
+ * Событие a раньше события b
  */
-void trit_to_symtrs(trs_t t) {
-	
-	int8_t i,j,n;
-	int8_t t0;
-	trs_t x;
-	
-	n = t.l;
+static inline uint8_t event_less(event_t *a, event_t *b) {
+	return (a->t < b->t) || (a->t == b->t && a->id < b->id);
+}
 
-	for (i=0;i<n;i++) {
-		x = t;					
-		x.tb >>= 2*(n-1-i);
-		t0 = trit2bit(x);
-		printf("%c", numb2symtrs(t0));
-	}	
-	return;
+/**
+ * Очистить очередь событий
+ */
+void event_clear(void) {
+	event_count = 0;
+	event_next = UINT64_MAX;
 }
 
 /**
- * Преобразовать триты с строку строки бумажной ленты
+ * Поставить событие fn(ctx) на время t
  *
- *  Пар:  v - триты
- *  Рез:  lp - строка линии ленты 
+ * Рез:  return=0 - OK', return|=0 - Error
  */
-void trit2linetape(trs_t v, uint8_t * lp) {	
+int8_t event_post(uint64_t t, uint8_t id, event_fn fn, void *ctx) {
+
+	uint8_t i;
+	uint8_t p;
+	event_t e;
+
+	if( event_count >= EVENT_NUMBER ) {
+		printf(" --- ERROR event queue full\r\n");
+		return -1;
+	}
+	e.t   = t;
+	e.id  = id;
+	e.fn  = fn;
+	e.ctx = ctx;
+
+	i = event_count++;
+	while( i > 0 ) {
+		p = (i - 1) / 2;
+		if( !event_less(&e, &event_heap[p]) ) {
+			break;
+		}
+		event_heap[i] = event_heap[p];
+		i = p;
+	}
+	event_heap[i] = e;
+	event_next = event_heap[0].t;
+	return 0;
 }
 
 /**
- * Преобразовать строку строки бумажной ленты в триты
- * 
- * Пар:  lp - строка линии ленты 
- * Рез:  return=0 - OK', return|=0 - Error
- * 		 v - триты	 
+ * Снять ближайшее событие
  */
-uint8_t linetape2trit(uint8_t * lp, trs_t * v) {
-	trs_t r;
-	r.l  = 0;
-	r.tb = 0;
-	*v = r;
-	return 0; /* OK' */
+event_t event_pop(void) {
+
+	uint8_t i;
+	uint8_t c;
+	event_t e;
+	event_t last;
+
+	e = event_heap[0];
+	last = event_heap[--event_count];
+
+	i = 0;
+	for(;;) {
+		c = 2 * i + 1;
+		if( c >= event_count ) {
+			break;
+		}
+		if( c + 1 < event_count && event_less(&event_heap[c + 1], &event_heap[c]) ) {
+			c++;
+		}
+		if( !event_less(&event_heap[c], &last) ) {
+			break;
+		}
+		event_heap[i] = event_heap[c];
+		i = c;
+	}
+	if( event_count > 0 ) {
+		event_heap[i] = last;
+	}
+	event_next = (event_count > 0) ? event_heap[0].t : UINT64_MAX;
+	return e;
 }
 
 /**
- * Печать троичного регистра 
- *  
+ * Выполнить события с временем до cycles
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
  */
-void view_short_reg(trs_t *t, uint8_t *ch) {
-	 int8_t i;
-	 int8_t l;
-	 trs_t tv;
-	 
-	 tv = *t;
-	 printf("%s: ",(char *)ch);
-	 //printf("%s=%i\t[",ch,tv.l);	 	 	 
-	 if( tv.l <= 0 ) {
-		 //printf("]\n");
-		 return;
-	 }
-	 else if(tv.l > SIZE_WORD_LONG) {
-		 l = SIZE_WORD_LONG;
-	 }
-	 else {
-		 l = tv.l;
-	 }
-	 
-	 printf("[");
-	 i=0;	 
-	 do {
-		  tv = *t;
-		  tv.tb >>= (l-1-i)*2 ; 
-		  printf("%i",trit2bit(tv));          		    		  
-		  //switch(trit2bit(tv)) {
-		  //	  case -1: printf("-"); break;
-		  //	  case  0: printf("0"); break;
-		  //	  case  1: printf("+"); break;
-		  //  }
-		  i++;          
-     } 
-	 while( i < l );
-	 printf("], ");
-	 printf("(%li), ",(long int)trs_to_digit(t));	 
-	 tv = *t;
-	 trit_to_str(tv);	 
-	 printf("\n");
+int8_t event_run(void) {
+
+	int8_t r;
+	event_t e;
+
+	r = 0;
+	while( event_next <= cycles ) {
+		e = event_pop();
+		if( e.fn(e.ctx) != 0 ) {
+			r = -1;
+		}
+	}
+	return r;
 }
 
 /**
- * Печать на электрифицированную пишущую машинку
- * 'An electrified typewriter'
+ * Ожидание машины до времени t: время пропускается
+ * от события к событию, события выполняются в своё время.
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
  */
-void electrified_typewriter(trs_t t, uint8_t local) {
-	
-	int32_t code;
-	
-	/* Регист переключения Русский/Латинский */
-	static uint8_t russian_latin_sw = 0;
-	/* Регист переключения Буквенный/Цифровой */
-	static uint8_t letter_number_sw = 0;
-	/* Регист переключения цвета печатающей ленты */
-	static uint8_t color_sw = 0;
+int8_t event_wait(uint64_t t) {
 
-	color_sw += 0;
+	int8_t r;
+	uint64_t now;
 
-	russian_latin_sw = local;
-	code = trs_to_digit(&t);
-	
-	switch( code ) {
-		case 6: /* t = 1-10 */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","А");
-							break;
-						default:  /* number */ 
-							printf("%s","6");
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","A");
-							break;
-						default:  /* number */ 
-							printf("%s","6");
-						break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case 7:  /* t = 1-11 */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","В");
-							break;
-						default:  /* number */ 
-							printf("%s","7");
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","B");							
-							break;
-						default:  /* number */ 
-							printf("%s","7");
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case 8:  /* t = 10-1 */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","С");
-							break;
-						default:  /* number */
-							printf("%s","8");
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","C");							
-							break;
-						default:  /* number */ 
-							printf("%s","8");
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case 9:  /* t = 100 */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","Д");							
-							break;
-						default:  /* number */ 
-							printf("%s","9");							
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","D");														
-							break;
-						default:  /* number */ 
-							printf("%s","9");							
-							break;	
-					}
-				break;
-			}
-		  	break;  
-		
-		case 10:  /* t = 101 */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","Е");							
-							break;
-						default:  /* number */ 
-							printf("%s"," ");							
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","E");														
-							break;
-						default:  /* number */ 
-							printf("%s"," ");							
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case -12:  /* t = -1-10 */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","Б");							
-							break;
-						default:  /* number */ 
-							printf("%s","-");							
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","F");														
-							break;
-						default:  /* number */ 
-							printf("%s","-");														
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case -9:  /* t = -100 */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","Щ");
-							break;
-						default:  /* number */ 
-							printf("%s","Ю");
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","G");							
-							break;
-						default:  /* number */ 
-							printf("%s","/");							
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case -8:  /* t = -101 */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","Н");
-							break;
-						default:  /* number */ 
-							printf("%s",",");
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","H");
-							break;
-						default:  /* number */ 
-							printf("%s",".");
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case -6:  /* t = -110  */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","I");
-							break;
-						default:  /* number */ 
-							printf("%s","+");
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","Л");							
-							break;
-						default:  /* number */ 
-							printf("%s","+");
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case -5:  /* t = -111 */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","Ы");
-							break;
-						default:  /* number */ 
-							printf("%s","Э");
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","J");							
-							break;
-						default:  /* number */ 
-							printf("%s","V");
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case -4:  /* t = 0-1-1 */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","К");							
-							break;
-						default:  /* number */ 
-							printf("%s","Ж");							
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","K");														
-							break;
-						default:  /* number */ 
-							printf("%s","W");														
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case -3:  /* t = 0-10  */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","Г");														
-							break;
-						default:  /* number */ 
-							printf("%s","Х");														
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","L");														
-							break;
-						default:  /* number */ 
-							printf("%s","X");														
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case -2:  /* t = 0-11  */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","М");
-							break;
-						default:  /* number */ 
-							printf("%s","У");
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","M");							
-							break;
-						default:  /* number */ 
-							printf("%s","Y");							
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case -1:  /* t = 00-1  */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","И");							
-							break;
-						default:  /* number */ 
-							printf("%s","Ц");							
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","N");														
-							break;
-						default:  /* number */ 
-							printf("%s","Z");														
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case 0:  /* t = 000  */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","Р");														
-							break;
-						default:  /* number */ 
-							printf("%s","О");														
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","P");																					
-							break;
-						default:  /* number */ 
-							printf("%s","O");																					
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case 1:  /* t = 001  */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","Й");																					
-							break;
-						default:  /* number */ 
-							printf("%s","1");																					
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","Q");																					
-							break;
-						default:  /* number */ 
-							printf("%s","1");																					
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case 2:  /* t = 01-1  */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","Я");																					
-							break;
-						default:  /* number */ 
-							printf("%s","2");																					
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","R");																					
-							break;
-						default:  /* number */ 
-							printf("%s","2");																					
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case 3:  /* t = 010  */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","Ь");																					
-							break;
-						default:  /* number */ 
-							printf("%s","3");																					
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","S");																					
-							break;
-						default:  /* number */ 
-							printf("%s","3");																					
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case 4:  /* t = 011  */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","Т");																					
-							break;
-						default:  /* number */ 
-							printf("%s","4");																					
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","T");																					
-							break;
-						default:  /* number */ 
-							printf("%s","4");																					
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case 5:  /* t = 1-1-1 */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","П");																					
-							break;
-						default:  /* number */ 
-							printf("%s","5");																					
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","U");																					
-							break;
-						default:  /* number */ 
-							printf("%s","5");																					
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case 13:  /* t = 111 */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","Ш");																					
-							break;
-						default:  /* number */ 
-							printf("%s","Ф");																					
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","(");																					
-							break;
-						default:  /* number */ 
-							printf("%s",")");																					
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case -7:  /* t = -11-1 */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","=");																					
-							break;
-						default:  /* number */ 
-							printf("%s","х");																					
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","=");																					
-							break;
-						default:  /* number */ 
-							printf("%s","x");																					
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case -11:  /* t = -1-11 */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-						// переключить цвет черный
-							break;
-						default:  /* number */ 
-						// переключить цвет красный
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","?");																					
-							break;
-						default:  /* number */ 
-							printf("%s","?");																					
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case 12:  /* t = 110  */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							letter_number_sw = 0;
-							break;
-						default:  /* number */ 
-							letter_number_sw = 0;
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							letter_number_sw = 0;							
-							break;
-						default:  /* number */ 
-							letter_number_sw = 0;
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case 11:  /* t = 11-1  */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							letter_number_sw = 1;
-							break;
-						default:  /* number */ 
-							letter_number_sw = 1;
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							letter_number_sw = 1;
-							break;
-						default:  /* number */ 
-							letter_number_sw = 1;
-							break;	
-					}
-				break;
-			}
-		  	break;  
-
-		case -10:  /* t = -10-1 */
-			switch( russian_latin_sw ) {
-				case 0: /* russian */
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","\r\n");
-							break;
-						default:  /* number */ 
-							printf("%s","\r\n");
-							break;	
-					}
-				break;
-				default: /* latin */ 
-					switch( letter_number_sw ) {
-						case 0: /* letter */ 
-							printf("%s","\r\n");
-							break;
-						default:  /* number */ 
-							printf("%s","\r\n");
-							break;	
-					}
-				break;
-			}
-		  	break;  
+	r = 0;
+	now = cycles;
+	while( event_next <= t ) {
+		if( event_next > now ) {
+			now = event_next;
+		}
+		cycles = now;
+		if( event_run() != 0 ) {
+			r = -1;
+		}
+	}
+	if( t > now ) {
+		now = t;
 	}
+	cycles = now;
+	return r;
 }
 
+/** *********************************************
+ *  Обмен зонами между DRUM и FRAM
+ *  ---------------------------------------------
+ *
+ *  Зона FRAM, 27 строк по два коротких слова, и зона DRUM
+ *  из 54 коротких слов лежат в памяти подряд и копируются целиком.
+ *
+ *  Модель вращения барабана: слова зоны проходят под головкой
+ *  по одному за DRUM_WORD_TIME тактов, обмен начинается
+ *  со слова 0 и длится один оборот барабана.
+ */
+#define DRUM_WORD_TIME		(370)	/* время прохода слова под головкой, такты */
+#define DRUM_TURN_TIME		(DRUM_WORD_TIME * SIZE_ZONE_TRIT_DRUM) /* оборот барабана */
+
+uint8_t drum_timing = 0;	/* учитывать вращение барабана */
+
 /**
- * Печать регистров машины Сетунь-1958 
+ * Ожидание слова 0 зоны под головкой барабана
  */
-void view_short_regs(void) {
-	int8_t i;
+uint32_t drum_latency(void) {
 
-	printf("[ Registers Setun-1958: ]\n");
+	uint32_t pos;
 
-	view_short_reg(&K," K");
-	view_short_reg(&F," F");	
-	view_short_reg(&C," C");
-	view_short_reg(&W," W");
-	view_short_reg(&S," S");	
-	view_short_reg(&R," R");
-	view_short_reg(&MB," MB");
+	if( drum_timing == 0 ) {
+		return 0;
+	}
+	pos = (uint32_t)(cycles % DRUM_TURN_TIME);
+	if( pos == 0 ) {
+		return 0;
+	}
+	return DRUM_TURN_TIME - pos;
 }
 
+/** *********************************************
+ *  Магнитный барабан в файле
+ *  ---------------------------------------------
+ *
+ *  Файл барабана: заголовок и 72 зоны по 54 коротких слова
+ *  в порядке байт машины хоста. Файл отображается в память,
+ *  содержимое барабана сохраняется между запусками машины.
+ *  В режиме только для чтения файл является общим образом
+ *  барабана для всех машин, запись идёт в собственные копии зон.
+ */
+#define DRUM_FILE_MAGIC		(0x52445453)	/* "STDR" */
+#define DRUM_FILE_VERSION	(1)
+
+typedef struct drum_file_hdr {
+	uint32_t magic;		/* сигнатура файла барабана */
+	uint32_t version;	/* версия формата файла */
+	uint32_t zones;		/* количество зон */
+	uint32_t words;		/* количество слов в зоне */
+} drum_file_hdr_t;
+
+void *drum_map = NULL;		/* отображение файла барабана */
+size_t drum_map_size = 0;	/* размер отображения */
+
 /**
- * Печать памяти FRAM машины Сетунь-1958 
+ * Подключить барабан к файлу, новый файл создаётся пустым
+ *
+ * Пар:  ro - 1: барабан только для чтения, запись не попадает в файл
+ * Рез:  return=0 - OK', return|=0 - Error
  */
-void view_fram(trs_t ea) {
-	int8_t j;
-	trs_t tv;
-	
-	uint8_t zind; 
-	uint8_t rind; 
-	int8_t eap5;
-	trs_t zr;
-	trs_t rr;	
-	trs_t res;
-	trishort r;
-	trishort t;
-	
-	/* Зона памяти FRAM */
-	zr = slice_trs(ea,5,5);
-	zr.l = 1;
-	zind = zone_fram_to_index(zr);
+int8_t drum_file_open(char *path, uint8_t ro) {
 
-	/* Индекс строки в зоне памяти FRAM */
-	rr = slice_trs(ea,1,4);	
-	rr.l = 4; 
-	rind = row_fram_to_index(rr);
-	
-	r = mem_fram[rind][zind];			
-	t = r;
-	
-	printf("ram[...] (%3d:%2d) = ", rind - SIZE_PAGE_TRIT_FRAM/2, zind );
-	printf(" hex = %08p [",r);			
-	
-	j = 0;	 	 		
-	do {		  
-		printf("%i",tb2int(r >> (9-1-j)*2));          		    		  
-		j++;          
-	} while( j < 9 );
-	
-	printf("], ");			
-	printf("(%li), ",(long int)tb_to_digit(t));	 	 	 		
+	int fd;
+	struct stat st;
+	drum_file_hdr_t hdr;
+	size_t size;
+	void *p;
 
-	tv.l = 9;
-	tv.tb = r & 0x3FFFF; 			
-	trit_to_str(tv);
-	printf("\n");		  		 		 
-	
-}
+	size = sizeof(drum_file_hdr_t) + SIZE_DRUM_BYTES;
 
-void dumpf( trs_t addr1, trs_t addr2) {
-	
-	trs_t ad1 = addr1;
-	trs_t ad2 = addr2;
-	int16_t a1 = trs_to_digit(&ad1);
-	int16_t a2 = trs_to_digit(&ad2);
-	//printf(" a1,a1 = %d", );
+	fd = open(path, ro ? O_RDONLY : (O_RDWR | O_CREAT), 0644);
+	if( fd < 0 ) {
+		printf(" --- ERROR open '%s'\r\n", path);
+		return -1;
+	}
+	if( fstat(fd, &st) != 0 ) {
+		close(fd);
+		return -1;
+	}
 
-	if( (a2 >= a1) && ( a2 >= ZONE_M_FRAM_BEG && a2 <= ZONE_P_FRAM_END ) && ( a2 >= ZONE_M_FRAM_BEG && a2 <= ZONE_P_FRAM_END ) ) {		
-		for( uint16_t i=0; i<(abs(a2-a1)); i++ ) {
-			if( trit2bit(ad1)>=0 ) {
-				view_fram(ad1);
-			}
-			inc_trs(&ad1);
-			if( trit2bit(ad1)<0 ) {
-				inc_trs(&ad1);
-				i += 1;
-			}
+	if( st.st_size == 0 && !ro ) {
+		/* Новый барабан */
+		hdr.magic   = DRUM_FILE_MAGIC;
+		hdr.version = DRUM_FILE_VERSION;
+		hdr.zones   = NUMBER_ZONE_DRUM;
+		hdr.words   = SIZE_ZONE_TRIT_DRUM;
+		if( ftruncate(fd, size) != 0 ||
+			pwrite(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr)
+		  ) {
+			close(fd);
+			printf(" --- ERROR write '%s'\r\n", path);
+			return -1;
 		}
 	}
+	else if( (size_t)st.st_size != size ||
+			 pread(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) ||
+			 hdr.magic != DRUM_FILE_MAGIC ||
+			 hdr.version != DRUM_FILE_VERSION ||
+			 hdr.zones != NUMBER_ZONE_DRUM ||
+			 hdr.words != SIZE_ZONE_TRIT_DRUM
+		   ) {
+		close(fd);
+		printf(" --- ERROR drum file '%s'\r\n", path);
+		return -1;
+	}
+
+	p = mmap(NULL, size, ro ? PROT_READ : (PROT_READ | PROT_WRITE), MAP_SHARED, fd, 0);
+	close(fd);
+	if( p == MAP_FAILED ) {
+		printf(" --- ERROR mmap '%s'\r\n", path);
+		return -1;
+	}
+
+	drum_file_close();
+	drum_map = p;
+	drum_map_size = size;
+	drum_bind((trishort (*)[SIZE_ZONE_TRIT_DRUM])((uint8_t *)p + sizeof(drum_file_hdr_t)), ro);
+
+	return 0;
 }
 
 /**
- * Печать памяти FRAM машины Сетунь-1958 
+ * Отключить барабан от файла, барабан снова в памяти машины
  */
-void dump_fram(void) {
-	
-	int8_t zone;
-	int8_t row;
-	int8_t j;
-	trishort r;
-	trishort t;
-	trs_t tv;
-
-	printf("\r\n[ Dump FRAM Setun-1958: ]\r\n");
+void drum_file_close(void) {
 
-	for(row=0; row < SIZE_PAGE_TRIT_FRAM; row++) {
-		for(zone=0; zone < SIZE_PAGES_FRAM; zone++) {
+	uint8_t z;
 
-			r = mem_fram[row][zone];			
-			t = r;
-			
-			printf("ram[...] (%3d:%2d) = ", row - SIZE_PAGE_TRIT_FRAM/2, zone );
-			printf(" hex = %08p [",r);			
-			
-			j = 0;	 	 		
-			do {		  
-		  		printf("%i",tb2int(r >> (9-1-j)*2));          		    		  
-		  		j++;          
-			} while( j < 9 );
-	 		
-			printf("], ");			
-	 		printf("(%li), ",(long int)tb_to_digit(t));	 	 	 		
-
-			tv.l = 9;
-			tv.tb = r & 0x3FFFF; 			
-			trit_to_str(tv);
-			printf("\n");		  		 		 
-		}
-	}		
+	if( drum_map == NULL ) {
+		return;
+	}
+	for(z=0; z < NUMBER_ZONE_DRUM; z++) {
+		memcpy(drum_store[z], mem_drum[z], SIZE_ZONE_BYTES);
+	}
+	drum_bind(drum_store, 0);
+	munmap(drum_map, drum_map_size);
+	drum_map = NULL;
+	drum_map_size = 0;
 }
 
 /**
- * Печать памяти DRUM машины Сетунь-1958 
+ * Обмен зоны FRAM A*(5) с зоной DRUM A*(1:4)
+ *
+ * Пар:  a - адрес A*(1:5)
+ *       wr - 1: (Фа*)=>(Мд*), 0: (Мд*)=>(Фа*)
+ * Рез:  return=0 - OK', return|=0 - Error
  */
-void dump_drum(void) {
+int8_t drum_xfer( trs_t a, uint8_t wr ) {
 
-	int8_t zone;
-	int8_t row;
-	int8_t j;
-	trishort r;
-	trishort t;
+	int8_t zind;
+	uint8_t fz;
+	uint8_t i;
+	trishort *fp;
 
-	for(zone=0; zone < NUMBER_ZONE_DRUM; zone++) {
-		for(row=0; row < SIZE_ZONE_TRIT_DRUM; row++) {
-			
-			r = mem_drum[zone][row];			
-			t = r;
-			
-			printf("drum[% 4i]  (%3d:%3d) = [", zone*SIZE_ZONE_TRIT_DRUM + row,zone-36,row-26);
-	 		
-			j = 0;	 
-	 		do {		  
-		  		printf("%i",tb2int(r >> (9-1-j)*2));          		    		  
-		  		j++;          
-			} while( j < 9 );
-	 		
-			printf("], ");
-	 		printf("(%li),\t",(long int)tb_to_digit(t));	 	 
-	 		printf("\n");		  		 		 
-		}
+	samp_phase = SAMP_DEVICE;
+	MB = slice_trs(a,1,4);
+	zind = mb_to_zone_index(MB);
+	if( zind < 0 ) {
+		return -1;
 	}
-}
 
-/** *******************************************
- *  Реалиазция виртуальной машины "Сетунь-1958"
- *  -------------------------------------------
- */
+	/* Зона FRAM: строки fz*27 ... fz*27+26 */
+	fz = (uint8_t)(get_trit_int(a,5) + 1);
+	fp = &mem_fram[fz * (SIZE_PAGE_TRIT_FRAM / 3)][0];
+	if( io_wait_zone(fz) != 0 ) {
+		return -1;
+	}
 
-/** 
- * Аппаратный сброс.
- * Очистить память и регистры
- * виртуальной машины "Сетунь-1958"
+	if( wr ) {
+		memcpy(drum_zone_wr(zind), fp, SIZE_ZONE_BYTES);
+		DRUM_TOUCH(zind);
+		vm_stat.drum_wr++;
+		if( vcd_on ) {
+			vcd_drum(zind);
+		}
+	}
+	else {
+		memcpy(fp, mem_drum[zind], SIZE_ZONE_BYTES);
+		vm_stat.drum_rd++;
+		for(i=0; i < SIZE_PAGE_TRIT_FRAM / 3; i++) {
+			FRAM_TOUCH(fz * (SIZE_PAGE_TRIT_FRAM / 3) + i);
+		}
+		if( vcd_on ) {
+			vcd_fram_zone(fz);
+		}
+	}
+
+	if( drum_timing ) {
+		return event_wait(cycles + drum_latency() + DRUM_TURN_TIME);
+	}
+	return 0;
+}
+
+/** ***********************************************
+ *  Алфавит троичной симметричной системы счисления
+ *  -----------------------------------------------
+ *  Троичный код в девятеричной системы 
+ *  -----------------------------------------------
+ *  С символами: W, X, Y, Z, 0, 1, 2, 3, 4.
  */
-void reset_setun_1958(void) {
-	// 
-	clean_fram();	/* Очистить  FRAM */
-	clean_drum();	/* Очистить  DRUM */
-	//
-	clear(&K);		/* K(1:9) */
-	K.l = 9;
-	clear(&F);		/* F(1:5) */
-	F.l = 5;
-	clear(&C);		/* K(1:5) */
-	C.l = 5;
-	clear(&W);		/* W(1:1) */
-	W.l = 1;  					
-	//	
-	clear(&S);		/* S(1:18) */
-	S.l = 18;  
-	clear(&R);		/* R(1:18) */
-	R.l = 18;  				
-	clear(&MB);		/* MB(1:4) */
-	MB.l = 4;  				
-	//
-	clear(&MR);		/* Временный регистр данных MR(1:9) */
-	MR.l = 9;
+uint8_t trit2lt( int8_t v )  {
+	switch( v ) {
+		case -4 : return 'W'; break;
+		case -3 : return 'X'; break;
+		case -2 : return 'Y'; break;
+		case -1 : return 'Z'; break;
+		case  0 : return '0'; break;
+		case  1 : return '1'; break;
+		case  2 : return '2'; break;
+		case  3 : return '3'; break;
+		case  4 : return '4'; break;
+		default : return '0'; break;	
+	}
 }
 
-/** 
- * Вернуть модифицированное K(1:9) для выполнения операции "Сетунь-1958"
+/**
+ * Вид '-','0','+' в десятичный код
  */
-trs_t control_trs( trs_t a ) {
-		int8_t k9;
-		trs_t k1_5;
-		trs_t r;
-		trs_t cn;
+int8_t symtrs2numb( uint8_t c )  {
+	switch( c ) {
+		case '-' :
+		 return -1 ; break;
+		case '0' :
+		 return 0; break;
+		case '+' :
+		 return 1; break;
+		default  : return 0; break;	
+	}
+}
 
-		k1_5 = slice_trs(a,1,5);
-		/* Признак модификации адремной части K(9) */
-		k9 = trit2bit(a); 
+/**
+ * Bp  Вид '-','0','+' 
+ */
+uint8_t numb2symtrs( int8_t v )  {
 		
-		/* Модицикация адресной части K(1:5) */
-		if( k9 >= 1 ) { 	/* A(1:5) = A(1:5) + F(1:5) */ 			
-			cn = add_trs(k1_5,F);
-			cn.tb <<= 4*2;
-			r.tb = a.tb & 0xFF; 		/* Очистить неиспользованные триты */
-			r.tb |= cn.tb & 0x3FF00 ;
-		}
-		else if( k9 <= -1 ) {	/* A(1:5) = A(1:5) - F(1:5) */
-			cn = sub_trs(k1_5,F);
-			cn.tb <<= 4*2;
-			r.tb = a.tb & 0xFF; 		/* Очистить неиспользованные триты */
-			r.tb |= cn.tb & 0x3FF00 ;
-		} 
-		else {					/* r = K(1:9) */
-			r = a;
-		}
-
-		r.l = 9;
+	if( v <= -1 ) {
+		return '-';
+	}
+	else if( v == 0 ) {
+		return '0';
+	}
+	else {
+		return '+';		
+	}
+		
+}
 
-		return r;
+/**
+ *  Вид '-','0','+' строка в десятичный код
+ */
+int8_t str_symtrs2numb( uint8_t * s )  {
+	int8_t i;
+	int8_t len;
+	int8_t res = 0;
+	
+	len = strlen(s);
+	
+	for(i=0;i<len;i++) {
+		res += symtrs2numb(s[i]) * pow3(i);
+		printf("%c",s[i]); 
+	}	
+	
+	return res;	
 }
 
-/***************************************************************************************
-                   Таблица операций машина "Сетунь-1958"
-----------------------------------------------------------------------------------------
-Код(троичный)     Код        Название операции           W       Содержание команды 
-+00        30         9        Посылка в S               w(S)    (A*)=>(S)
-+0+        33        10        Сложение в S              w(S)    (S)+(A*)=>(S)
-+0-        3х         8        Вычитание в S             w(S)    (S)-(A*)=>(S)
-++0        40        12        Умножение 0               w(S)    (S)=>(R); (A*)(R)=>(S)
-+++        43        13        Умножение +               w(S)    (S)+(A*)(R)=>(S)
-++-        4х        11        Умножение -               w(S)    (A*)+(S)(R)=>(S)
-+-0        20         6        Поразрядное умножение     w(S)    (A*)[x](S)=>(S)
-+-+        23         7        Посылка в R               w(R)    (A*)=>(R)
-+--        2х         5        Останов    Стоп;          w(R)    STOP; (A*)=>(C)
-0+0        10         3        Условный переход 0         -      A*=>(C) при w=0
-0++        13         4        Условный переход +         -      A*=>(C) при w=+
-0+-        1х         2        Условный переход -         -      A*=>(C) при w=-
-000        00         0        Безусловный переход        -      A*=>(C)
-00+        03         1        Запись из C                -      (C)=>(A*)
-00-        0х        -1        Запись из F               w(F)    (F)=>(A*)
-0-0        ц0        -3        Посылка в F               w(F)    (A*)=>(F)
-0--        цх        -4        Сложение в F              w(F)    (F)+(A*)=>(F)
-0-+        ц3        -2        Сложение в F c (C)        w(F)    (C)+(A*)=>(F)
--+0        у0        -6        Сдвиг (S) на              w(S)    (A*)=>(S)
--++        у3        -5        Запись из S               w(S)    (S)=>(A*)
--+-        ух        -7        Нормализация              w(S)    Норм.(S)=>(A*); (N)=>(S)
--00        х0        -9        Вывод-ввод    Ввод в Фа*.  -      Вывод из Фа*
--0+        х3        -8        Запись на МБ               -      (Фа*)=>(Мд*)
--0-        хх        -10        Считывание с МБ           -      (Мд*)=>(Фа*)
---0        ж0        -12        Не задействована                 Аварийный стоп
---+        ж3        -11        Не задействована                 Аварийный стоп
----        жх        -13        Не задействована                 Аварийный стоп
-------------------------------------------------------------------------------------------
-*/
 /**
- * Выполнить операцию K(1:9) машины "Сетунь-1958"
+ *  Cтроку вида '-','0','+'  в троичное число
  */
-int8_t execute_trs( trs_t addr, trs_t oper ) {
-//TODO для С(5) = -1 выполнить 2-раза страшей половине A(9:18) и сделать inc C
+trs_t smtr(uint8_t * s) {
 
-		trs_t  k1_5; 		/* K(1:5)	*/
-		trs_t  k6_8; 		/* K(6:8)	*/
-		int8_t codeoper;	/* Код операции */
+      int8_t i;
+      int8_t trit;
+      int8_t len,lenmax;
+      trs_t t;
 
-		/* Адресная часть */	
-		k1_5 = slice_trs(addr,1,5);
-		k1_5.l = 5;
+      len = strlen(s);
+      lenmax = len;
+      t.l = len;
+      t.tb = 0;
+      
+      if(len > SIZE_WORD_LONG) {
+       t.l = SIZE_WORD_LONG;
+       lenmax = SIZE_WORD_LONG;
+      }
 
-		/* Код операции */	
-		k6_8 = oper;
-		k6_8.l = 3;
+      for(i=0;i<lenmax;i++){
+         trit = symtrs2numb( *(s+(len-i-1)) );
+         set_trit(&t,len-i,trit);
+      }
+      return t;
+}
 
-		codeoper = get_trit_int(k6_8,1)*9 +
-		           get_trit_int(k6_8,2)*3 +
-				   get_trit_int(k6_8,3);		
-		
-		/* ---------------------------------------
-		*  Выполнить операцию машины "Сетунь-1958"
-		*  ---------------------------------------
-		*/
+/**
+ * Девятеричный вид в троичный код
+ */
+uint8_t * lt2symtrs( int8_t v )  {
+	switch( v ) {
+		case 'W' :
+		case 'w' :
+		 return "--" ; break;
+		case 'X' :
+		case 'x' :
+		 return "-0"; break;
+		case 'Y' :
+		case 'y' :
+		 return "-+"; break;
+		case 'Z' :
+		case 'z' :
+		 return "0-"; break;		
+		case '0' : return "00"; break;
+		case '1' : return "0+"; break;
+		case '2' : return "+-"; break;
+		case '3' : return "+0"; break;
+		case '4' : return "++"; break;
+		default  : return "  "; break;	
+	}
+}
 
-		/*
-		* Описание реализации команд машины «Сетунь»
-		*
-		* 5-разрядный регистр управления С, в котором содержится адрес
-		* выполняемой команды, после выполнения каждой команды в регистре С
-		* формируется адрес следующей команды причём за командой являющейся первой
-		* коротким кодом какой-либо ячейки, следует­ команда, являющаяся вторым 
-		* коротким кодом этой ячейки, а вслед за ней — ко­манда, являющаяся первым
-		* коротким кодом следующей ячейки, и т. д.;
-		* этот порядок может быть нарушен при выполнении команд
-		* перехода.
-		*
-		* При выполнении команд, использую­щих регистры F и С, операции производятся
-		* над 5-разрядными кодами, которые можно рассматривать как целые числа. 
-		* При выборке из памяти 5-разрядный код рассматривается как старшие пять разрядов 
-		* соответст­вующего короткого или длинного кода, при запоминании в ячейке 
-		* па­мяти 5-разрядный код записывается в старшие пять разрядов и допол­няется
-		* до соответствующего короткого или длинного кода записью нулей в остальные разряды.
-		* 
-		* При выполнении команд, использующих регистры S и R, выбираемые из памяти короткие коды
-		* рассматриваются как длин­ные с добавлением нулей в девять младших разрядов, а в оперативную
-        * память в качестве короткого кода записывается содержимое девяти старших разрядов регистра S 
-		* (запись в оперативную память непосред­ственно из регистра R невозможна).
-		*		
-		* После выполнения каждой команды вырабатывается значение неко­торого признака W = W(X) {-1,0,1}, 
-		* где X — обозначение какого-либо регистра, или сохраняется предыду­щее значение этого признака.		  
-        * 
-		* Команды условного перехода выполняются по-разному в зависимости от значения этого признака W.
-		* 
-		* При выполнении операций сложения, вычитания и умножения, использующих регистр S,
-		* может произойти останов машины по переполнению, если результат выполнения
+/**
+ *  Троичный код в девятеричной системы 
+ *
+ *  С символами: W, X, Y, Z, 0, 1, 2, 3, 4. 
+ */
+uint8_t trit_to_lt( int8_t v )  {
+	switch( v ) {
+		case -4 : return 'W'; break;
+		case -3 : return 'X'; break;
+		case -2 : return 'Y'; break;
+		case -1 : return 'Z'; break;
+		case  0 : return '0'; break;
+		case  1 : return '1'; break;
+		case  2 : return '2'; break;
+		case  3 : return '3'; break;
+		case  4 : return '4'; break;
+		default : return '0'; break;	
+	}
+}
+
+/**
+ * Троичный код в девятеричной системы 
+ *
+ */
+int32_t trs_to_digit( trs_t *tr )  {
+
+	int32_t l;    
+    int8_t i;
+    trs_t x;
+
+    l = 0;
+    x = *tr;	
+    for( i=0; i<x.l ; i++ ) {		    						
+			x = *tr;
+			x.tb >>= (i*2);		
+			l += trit2bit(x) * pow3(i);
+    }
+    
+	return l;
+}
+
+/**
+ * Троичный код в девятеричной системы 
+ *
+ *  С символами: Ж, Х, У, Ц, 0, 1, 2, 3, 4. 
+ */
+int32_t tb_to_digit( trishort tb )  {
+
+	int32_t l;    
+    int8_t i;
+
+    l = 0;   
+    for( i=0; i<9 ; i++ ) {		    						
+			l += tb2int(tb >> (i*2)) * pow3(i);
+    }
+    
+	return l;
+}
+
+/**
+ * Девятеричный вид в троичный код
+ */
+void cmd_str_2_trs( uint8_t * syms, trs_t * r )  {
+	
+	uint8_t i;
+	uint8_t symtrs_str[40];
+
+	if( strlen(syms) != 5) {
+		r->l  = 9;
+		r->tb = 0;
+		printf(" --- ERROR syms\r\n");
+		return;
+	}	
+
+	sprintf(symtrs_str,"%2s%2s%2s%2s%2s",
+			lt2symtrs(syms[0]),
+			lt2symtrs(syms[1]),
+			lt2symtrs(syms[2]),
+			lt2symtrs(syms[3]),
+			lt2symtrs(syms[4])			
+		);	
+
+	for(i=1;i<10;i++) {
+		set_trit(r,i,symtrs2numb(symtrs_str[i]));		
+	}		
+}
+
+/**
+ * Печать троичного числа в строку
+ */
+void trit_to_str(trs_t t) {
+	
+	int8_t i,j,n;
+	int8_t t0,t1;
+	trs_t x;
+	
+	n = t.l + 1;
+
+	for (i=0;i<n;i+=2) {
+		x = t;	
+		x.tb >>= (n-2-i)*2 ;
+		t0 = trit2bit(x);
+		x.tb >>= 2;
+		t1 = trit2bit(x);
+
+		printf("%c",trit_to_lt( t1*3 + t0 ));	
+	}
+
+	return;
+}
+
+/**
+ * Печать троичного числа в строку
+ */
+void trit_to_symtrs(trs_t t) {
+	
+	int8_t i,j,n;
+	int8_t t0;
+	trs_t x;
+	
+	n = t.l;
+
+	for (i=0;i<n;i++) {
+		x = t;					
+		x.tb >>= 2*(n-1-i);
+		t0 = trit2bit(x);
+		printf("%c", numb2symtrs(t0));
+	}	
+	return;
+}
+
+/**
+ * Строка перфоленты: 5 дорожек, 'o' - пробивка, '.' - нет пробивки.
+ * Пробивки дорожек 1...5 (дорожка 1 старшая) образуют двоичное число
+ * p = код + 13 трёхтритного кода -13...+13, числа 27...31 не допустимы.
+ */
+#define TAPE_TRACKS		(5)		/* количество дорожек перфоленты */
+#define TAPE_NO_CODE	(0xFF)	/* недопустимая строка перфоленты */
+
+/**
+ * Поле битов трёхтритного кода по пробивкам строки перфоленты
+ */
+static const uint8_t linetape_tab[32] = {
+	0x15, 0x14, 0x16, 0x11, 0x10, 0x12, 0x19, 0x18, 0x1A,	/* -13...-5 */
+	0x05, 0x04, 0x06, 0x01, 0x00, 0x02, 0x09, 0x08, 0x0A,	/*  -4...+4 */
+	0x25, 0x24, 0x26, 0x21, 0x20, 0x22, 0x29, 0x28, 0x2A,	/*  +5...+13 */
+	TAPE_NO_CODE, TAPE_NO_CODE, TAPE_NO_CODE, TAPE_NO_CODE, TAPE_NO_CODE
+};
+
+/**
+ * Пробивка дорожки по символу строки перфоленты плюс 1:
+ * 1 - нет пробивки, 2 - пробивка, 0 - недопустимый символ
+ */
+static const uint8_t linetape_hole[256] = {
+	['.'] = 1, [' '] = 1, ['0'] = 1,
+	['o'] = 2, ['O'] = 2, ['*'] = 2, ['1'] = 2
+};
+
+/**
+ * Преобразовать строку строки бумажной ленты в триты
+ * 
+ * Пар:  lp - строка линии ленты 
+ * Рез:  return=0 - OK', return|=0 - Error
+ * 		 v - триты	 
+ */
+uint8_t linetape2trit(uint8_t * lp, trs_t * v) {
+
+	uint8_t i;
+	uint8_t h;
+	uint8_t p;
+
+	v->l  = 3;
+	v->tb = 0;
+
+	p = 0;
+	for(i=0; i<TAPE_TRACKS; i++) {
+		h = linetape_hole[lp[i]];
+		if( h == 0 ) {
+			return 1; /* Error */
+		}
+		p = (p << 1) | (h - 1);
+	}
+	if( linetape_tab[p] == TAPE_NO_CODE ) {
+		return 1; /* Error */
+	}
+	v->tb = linetape_tab[p];
+	return 0; /* OK' */
+}
+
+/**
+ * Пробивки строки перфоленты по полю битов трёхтритного кода,
+ * обратная таблица linetape_tab
+ */
+static const uint8_t linetape_code[64] = {
+	13, 12, 14, TAPE_NO_CODE, 10,  9, 11, TAPE_NO_CODE, 16, 15, 17, TAPE_NO_CODE, TAPE_NO_CODE, TAPE_NO_CODE, TAPE_NO_CODE, TAPE_NO_CODE,
+	 4,  3,  5, TAPE_NO_CODE,  1,  0,  2, TAPE_NO_CODE,  7,  6,  8, TAPE_NO_CODE, TAPE_NO_CODE, TAPE_NO_CODE, TAPE_NO_CODE, TAPE_NO_CODE,
+	22, 21, 23, TAPE_NO_CODE, 19, 18, 20, TAPE_NO_CODE, 25, 24, 26, TAPE_NO_CODE, TAPE_NO_CODE, TAPE_NO_CODE, TAPE_NO_CODE, TAPE_NO_CODE,
+	[48 ... 63] = TAPE_NO_CODE
+};
+
+/**
+ * Преобразовать триты с строку строки бумажной ленты
+ *
+ *  Пар:  v - трёхтритный код
+ *  Рез:  lp - строка линии ленты, 5 символов 'o' или '.'
+ */
+void trit2linetape(trs_t v, uint8_t * lp) {
+
+	uint8_t i;
+	uint8_t p;
+
+	p = linetape_code[v.tb & 0x3F];
+	if( p == TAPE_NO_CODE ) {
+		p = 13; /* недопустимые триты пробиваются как 000 */
+	}
+	for(i=0; i<TAPE_TRACKS; i++) {
+		lp[i] = ((p >> (TAPE_TRACKS - 1 - i)) & 1) ? 'o' : '.';
+	}
+}
+
+/** *********************************************
+ *  Кольца устройств и поток ввода-вывода хоста
+ *  ---------------------------------------------
+ *
+ *  Кольцо одного производителя и одного потребителя без блокировок:
+ *  счётчики head и tail только растут, каждый пишет своя сторона.
+ *  При `--async-io` файлы ptr0, ptr1, up0, ptp0, lpt0, tty0 читает
+ *  и пишет поток хоста, машина только копирует байты в кольцо
+ *  и из кольца. Без него кольцо обслуживает сама машина.
+ *  Когда хост не успевает, обмен -00 откладывается: устройство
+ *  остаётся занятым во времени машины, машина не блокируется.
+ */
+#define IO_RING_SIZE	(1 << 18)	/* кольцо устройства, степень 2 */
+#define IO_BUSY			(1)			/* обмен отложен: кольцо не готово */
+#define IO_RETRY_TIME	(1000)		/* повтор отложенного обмена, такты */
+
+typedef struct io_ring {
+	_Atomic uint64_t head;			/* записано в кольцо */
+	_Atomic uint64_t tail;			/* прочитано из кольца */
+	uint8_t buf[IO_RING_SIZE];
+} io_ring_t;
+
+uint8_t io_async = 0;				/* файлы устройств в потоке хоста */
+static sem_t io_sem;				/* пробуждение потока хоста */
+static pthread_mutex_t io_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t io_cond = PTHREAD_COND_INITIALIZER;	/* проход потока хоста окончен */
+static uint64_t io_passes;			/* счетчик проходов потока хоста, под io_lock */
+
+/**
+ * Количество байт в кольце
+ */
+static inline uint64_t ring_used(io_ring_t *r) {
+	return atomic_load_explicit(&r->head, memory_order_acquire) -
+		   atomic_load_explicit(&r->tail, memory_order_acquire);
+}
+
+/**
+ * Очистить кольцо, обе стороны остановлены
+ */
+void ring_reset(io_ring_t *r) {
+	atomic_store_explicit(&r->head, 0, memory_order_relaxed);
+	atomic_store_explicit(&r->tail, 0, memory_order_relaxed);
+}
+
+/**
+ * Записать n байт в кольцо, место проверено (производитель)
+ */
+void ring_put(io_ring_t *r, const uint8_t *p, uint32_t n) {
+
+	uint64_t h;
+	uint32_t i;
+	uint32_t k;
+
+	h = atomic_load_explicit(&r->head, memory_order_relaxed);
+	i = (uint32_t)(h & (IO_RING_SIZE - 1));
+	k = IO_RING_SIZE - i;
+	if( k > n ) {
+		k = n;
+	}
+	memcpy(r->buf + i, p, k);
+	memcpy(r->buf, p + k, n - k);
+	atomic_store_explicit(&r->head, h + n, memory_order_release);
+}
+
+/**
+ * Прочитать до n байт из кольца (потребитель)
+ *
+ * Рез:  количество прочитанных байт
+ */
+uint32_t ring_get(io_ring_t *r, uint8_t *p, uint32_t n) {
+
+	uint64_t t;
+	uint64_t u;
+	uint32_t i;
+	uint32_t k;
+
+	t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+	u = atomic_load_explicit(&r->head, memory_order_acquire) - t;
+	if( n > u ) {
+		n = (uint32_t)u;
+	}
+	i = (uint32_t)(t & (IO_RING_SIZE - 1));
+	k = IO_RING_SIZE - i;
+	if( k > n ) {
+		k = n;
+	}
+	memcpy(p, r->buf + i, k);
+	memcpy(p + k, r->buf, n - k);
+	atomic_store_explicit(&r->tail, t + n, memory_order_release);
+	return n;
+}
+
+/**
+ * Непрерывный участок данных кольца для записи в файл (потребитель)
+ *
+ * Рез:  количество байт, p - начало участка
+ */
+uint32_t ring_data(io_ring_t *r, uint8_t **p) {
+
+	uint64_t t;
+	uint64_t u;
+	uint32_t i;
+
+	t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+	u = atomic_load_explicit(&r->head, memory_order_acquire) - t;
+	i = (uint32_t)(t & (IO_RING_SIZE - 1));
+	*p = r->buf + i;
+	return (uint32_t)(u < IO_RING_SIZE - i ? u : IO_RING_SIZE - i);
+}
+
+/**
+ * Снять n байт участка данных (потребитель)
+ */
+void ring_skip(io_ring_t *r, uint32_t n) {
+	atomic_fetch_add_explicit(&r->tail, n, memory_order_release);
+}
+
+/**
+ * Непрерывный свободный участок кольца для чтения из файла (производитель)
+ *
+ * Рез:  количество байт, p - начало участка
+ */
+uint32_t ring_room(io_ring_t *r, uint8_t **p) {
+
+	uint64_t h;
+	uint64_t f;
+	uint32_t i;
+
+	h = atomic_load_explicit(&r->head, memory_order_relaxed);
+	f = IO_RING_SIZE - (h - atomic_load_explicit(&r->tail, memory_order_acquire));
+	i = (uint32_t)(h & (IO_RING_SIZE - 1));
+	*p = r->buf + i;
+	return (uint32_t)(f < IO_RING_SIZE - i ? f : IO_RING_SIZE - i);
+}
+
+/**
+ * Добавить n байт, прочитанных в свободный участок (производитель)
+ */
+void ring_commit(io_ring_t *r, uint32_t n) {
+	atomic_fetch_add_explicit(&r->head, n, memory_order_release);
+}
+
+/**
+ * Разбудить поток хоста
+ */
+void io_wake(void) {
+	if( io_async ) {
+		sem_post(&io_sem);
+	}
+}
+
+/**
+ * Разбудить поток хоста и дождаться его полного прохода
+ * по устройствам. Машина ждёт без опроса, вызывающий
+ * проверяет своё условие снова.
+ */
+void io_wait(void) {
+
+	uint64_t s;
+
+	pthread_mutex_lock(&io_lock);
+	s = io_passes;
+	/* Проход, начатый до вызова, мог пропустить условие */
+	while( io_async && io_passes < s + 2 ) {
+		io_wake();
+		pthread_cond_wait(&io_cond, &io_lock);
+	}
+	pthread_mutex_unlock(&io_lock);
+}
+
+/**
+ * Проход потока хоста окончен (поток хоста)
+ */
+void io_pass_done(void) {
+	pthread_mutex_lock(&io_lock);
+	io_passes++;
+	pthread_cond_broadcast(&io_cond);
+	pthread_mutex_unlock(&io_lock);
+}
+
+/** *********************************************
+ *  Фотосчитыватели перфоленты ptr0, ptr1
+ *  ---------------------------------------------
+ *
+ *  Файл ленты читается блоками в буфер устройства,
+ *  строки ленты разбираются из буфера без вызовов read().
+ *  При `--async-io` блоки читает поток хоста в кольцо устройства.
+ *  Короткое слово 9 тритов вводится тремя строками ленты,
+ *  старшие триты первыми.
+ */
+#define TAPE_BUF_SIZE	(65536)	/* буфер чтения ленты */
+#define TAPE_ZONE_BYTES	(SIZE_ZONE_TRIT_DRUM * 3 * (TAPE_TRACKS + 2)) /* зона строками "\r\n" */
+
+typedef struct tape_reader {
+	char *name;					/* имя устройства */
+	int fd;						/* файл ленты */
+	uint64_t offset;			/* позиция ленты в файле */
+	uint64_t base;				/* позиция в файле начала буфера */
+	uint32_t pos;				/* позиция чтения в буфере */
+	uint32_t len;				/* количество байт в буфере */
+	uint8_t buf[TAPE_BUF_SIZE];	/* буфер ленты */
+	_Atomic uint8_t eof;		/* поток хоста дочитал файл */
+	_Atomic uint8_t pause;		/* машина останавливает чтение хоста */
+	_Atomic uint8_t paused;		/* поток хоста не читает файл */
+	io_ring_t ring;				/* кольцо чтения потоком хоста */
+} tape_reader_t;
+
+tape_reader_t ptr_dev[2] = {
+	{ .name = "ptr0", .fd = -1 },
+	{ .name = "ptr1", .fd = -1 }
+};
+
+/**
+ * Остановить и продолжить чтение файла потоком хоста.
+ * Флаг paused сбрасывает только поток хоста, перед чтением
+ * он проверяет pause снова, поэтому старый paused=1
+ * не пропускает машину к файлу во время чтения.
+ */
+void ptr_pause(tape_reader_t *t) {
+	if( io_async ) {
+		atomic_store(&t->pause, 1);
+		while( !atomic_load(&t->paused) ) {
+			io_wait();
+		}
+	}
+}
+
+void ptr_resume(tape_reader_t *t) {
+	if( io_async ) {
+		atomic_store(&t->pause, 0);
+		io_wake();
+	}
+}
+
+/**
+ * Установить ленту в позицию offset, буфер читается заново
+ */
+void ptr_seek(tape_reader_t *t, uint64_t offset) {
+
+	ptr_pause(t);
+	t->offset = offset;
+	t->base = offset;
+	t->pos = 0;
+	t->len = 0;
+	ring_reset(&t->ring);
+	atomic_store_explicit(&t->eof, 0, memory_order_relaxed);
+	if( t->fd >= 0 ) {
+		lseek(t->fd, (off_t)offset, SEEK_SET);
+	}
+	ptr_resume(t);
+}
+
+/**
+ * Установить файл ленты в фотосчитыватель
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t ptr_open(tape_reader_t *t, char *path) {
+
+	ptr_pause(t);
+	if( t->fd >= 0 ) {
+		close(t->fd);
+	}
+	t->fd = open(path, O_RDONLY);
+	ptr_resume(t);
+	if( t->fd < 0 ) {
+		printf(" --- ERROR open '%s'\r\n", path);
+		return -1;
+	}
+	ptr_seek(t, t->offset);
+	return 0;
+}
+
+/**
+ * Зона ленты прочитана хостом или файл дочитан
+ */
+uint8_t ptr_ready(tape_reader_t *t) {
+	if( !io_async || t->fd < 0 || atomic_load_explicit(&t->eof, memory_order_acquire) ) {
+		return 1;
+	}
+	return (t->len - t->pos) + ring_used(&t->ring) >= TAPE_ZONE_BYTES;
+}
+
+/**
+ * Дочитать буфер ленты, непрочитанный остаток переносится в начало
+ *
+ * Рез:  количество новых байт, 0 - конец ленты
+ */
+uint32_t ptr_fill(tape_reader_t *t) {
+
+	ssize_t n;
+
+	if( t->pos > 0 ) {
+		memmove(t->buf, t->buf + t->pos, t->len - t->pos);
+		t->base += t->pos;
+		t->len -= t->pos;
+		t->pos = 0;
+	}
+	if( io_async ) {
+		for(;;) {
+			n = ring_get(&t->ring, t->buf + t->len, TAPE_BUF_SIZE - t->len);
+			if( n > 0 ) {
+				io_wake();
+				break;
+			}
+			if( atomic_load_explicit(&t->eof, memory_order_acquire) ) {
+				n = ring_get(&t->ring, t->buf + t->len, TAPE_BUF_SIZE - t->len);
+				break;
+			}
+			io_wait(); /* хост ещё не прочитал строку */
+		}
+	}
+	else {
+		n = read(t->fd, t->buf + t->len, TAPE_BUF_SIZE - t->len);
+	}
+	if( n <= 0 ) {
+		return 0;
+	}
+	t->len += (uint32_t)n;
+	return (uint32_t)n;
+}
+
+/**
+ * Прочитать непустую строку файла без '\r\n'
+ *
+ * Рез:  return - длина строки, 0 - конец файла
+ *       lp - начало строки в буфере
+ */
+uint32_t ptr_read_line(tape_reader_t *t, uint8_t **lp) {
+
+	uint8_t *p;
+	uint8_t *e;
+	uint32_t n;
+
+	if( t->fd < 0 ) {
+		return 0;
+	}
+
+	for(;;) {
+		p = t->buf + t->pos;
+		e = memchr(p, '\n', t->len - t->pos);
+		if( e == NULL ) {
+			if( ptr_fill(t) > 0 ) {
+				continue;
+			}
+			if( t->pos == t->len ) {
+				return 0; /* конец файла */
+			}
+			e = t->buf + t->len; /* последняя строка без '\n' */
+			p = t->buf + t->pos;
+		}
+
+		n = (uint32_t)(e - p);
+		t->pos += n + (e < t->buf + t->len ? 1 : 0);
+		t->offset = t->base + t->pos;
+
+		if( n > 0 && p[n-1] == '\r' ) {
+			n--;
+		}
+		if( n == 0 ) {
+			continue; /* пустая строка */
+		}
+		*lp = p;
+		return n;
+	}
+}
+
+/**
+ * Прочитать строку ленты
+ *
+ * Рез:  return=0 - OK', 1 - конец ленты, -1 - Error
+ *       v - трёхтритный код строки
+ */
+int8_t ptr_read_row(tape_reader_t *t, trs_t *v) {
+
+	uint8_t *p;
+	uint32_t n;
+
+	n = ptr_read_line(t, &p);
+	if( n == 0 ) {
+		return 1; /* конец ленты */
+	}
+	if( n != TAPE_TRACKS ) {
+		return -1;
+	}
+	return linetape2trit(p, v) ? -1 : 0;
+}
+
+/**
+ * Ввод с ленты в зону FRAM fz (0...2) до 54 коротких слов.
+ * Слова после конца ленты заполняются нулями.
+ *
+ * Рез:  return=0 - OK', return|=0 - Error или нет ленты
+ */
+int8_t ptr_read_zone(void *ctx, uint8_t fz, trishort *zone) {
+
+	tape_reader_t *t = ctx;
+	uint8_t i;
+	uint8_t j;
+	int8_t r;
+	trishort w;
+	trishort *fp;
+	trs_t v;
+
+	(void)zone;
+	if( !ptr_ready(t) ) {
+		return IO_BUSY;
+	}
+	fp = &mem_fram[fz * (SIZE_PAGE_TRIT_FRAM / 3)][0];
+
+	for(i=0; i < SIZE_ZONE_TRIT_DRUM; i++) {
+		w = 0;
+		for(j=0; j<3; j++) {
+			r = ptr_read_row(t, &v);
+			if( r < 0 ) {
+				printf(" --- ERROR tape '%s'\r\n", t->name);
+				return -1;
+			}
+			if( r > 0 ) {
+				break;
+			}
+			w = (w << 6) | (trishort)v.tb;
+		}
+		if( r > 0 ) {
+			if( i == 0 && j == 0 ) {
+				return -1; /* нет ленты */
+			}
+			w <<= 6 * (3 - j);
+			fp[i] = w;
+			memset(&fp[i+1], 0, (SIZE_ZONE_TRIT_DRUM - i - 1) * sizeof(trishort));
+			break;
+		}
+		fp[i] = w;
+	}
+
+	for(i=0; i < SIZE_PAGE_TRIT_FRAM / 3; i++) {
+		FRAM_TOUCH(fz * (SIZE_PAGE_TRIT_FRAM / 3) + i);
+	}
+	return 0;
+}
+
+/** *********************************************
+ *  Перфоратор ptp0 и печать lpt0
+ *  ---------------------------------------------
+ *
+ *  Слова зоны кодируются в кольцо устройства, кольцо
+ *  записывается в файл большими write() при заполнении,
+ *  при останове машины и при выходе из эмулятора,
+ *  при `--async-io` - потоком хоста.
+ */
+typedef struct out_dev {
+	char *name;				/* имя устройства */
+	int fd;					/* файл вывода */
+	uint64_t offset;		/* позиция вывода в файле */
+	io_ring_t ring;			/* кольцо вывода */
+} out_dev_t;
+
+#define OUT_PTP0		(0)		/* перфоратор */
+#define OUT_LPT0		(1)		/* печать */
+#define OUT_TTY0		(2)		/* пишущая машинка */
+#define OUT_NUMBER_DEVS	(3)		/* количество устройств вывода */
+
+out_dev_t out_dev[OUT_NUMBER_DEVS] = {
+	{ .name = "ptp0", .fd = -1 },
+	{ .name = "lpt0", .fd = -1 },
+	{ .name = "tty0", .fd = STDOUT_FILENO }	/* без файла печатает на терминал */
+};
+
+/**
+ * Записать n байт в файл целиком
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t out_write(out_dev_t *d, uint8_t *p, uint32_t n) {
+
+	ssize_t w;
+
+	if( d->fd == STDOUT_FILENO ) {
+		fflush(stdout); /* порядок с выводом printf() */
+	}
+	while( n > 0 ) {
+		w = write(d->fd, p, n);
+		if( w <= 0 ) {
+			printf(" --- ERROR write '%s'\r\n", d->name);
+			return -1;
+		}
+		p += w;
+		n -= (uint32_t)w;
+	}
+	return 0;
+}
+
+/**
+ * Записать кольцо устройства в файл
+ * без потока хоста, с потоком хоста - разбудить поток
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t out_flush(out_dev_t *d) {
+
+	int8_t r;
+	uint8_t *p;
+	uint32_t n;
+
+	if( io_async ) {
+		io_wake();
+		return 0;
+	}
+	r = 0;
+	while( (n = ring_data(&d->ring, &p)) > 0 ) {
+		if( d->fd >= 0 && out_write(d, p, n) != 0 ) {
+			r = -1;
+		}
+		ring_skip(&d->ring, n);
+	}
+	return r;
+}
+
+/**
+ * Дождаться записи кольца устройства потоком хоста
+ */
+void out_wait(out_dev_t *d) {
+	while( ring_used(&d->ring) != 0 ) {
+		io_wait();
+	}
+}
+
+/**
+ * Есть место для n байт в кольце устройства.
+ * Без потока хоста полное кольцо записывается сразу.
+ */
+uint8_t out_room(out_dev_t *d, uint32_t n) {
+
+	if( IO_RING_SIZE - ring_used(&d->ring) >= n ) {
+		return 1;
+	}
+	if( !io_async ) {
+		out_flush(d);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * Вывести n байт в кольцо устройства
+ */
+void out_put(out_dev_t *d, const uint8_t *p, uint32_t n) {
+
+	while( !out_room(d, n) ) {
+		io_wait(); /* вывод вне операции -00 ждёт поток хоста */
+	}
+	ring_put(&d->ring, p, n);
+	d->offset += n;
+}
+
+/**
+ * Установить позицию вывода offset, вывод после неё отбрасывается
+ */
+void out_seek(out_dev_t *d, uint64_t offset) {
+
+	struct stat st;
+
+	if( io_async ) {
+		out_wait(d);
+	}
+	ring_reset(&d->ring);
+	d->offset = offset;
+	if( d->fd > STDERR_FILENO ) {
+		/* Устройство хоста, например /dev/null, не усекается */
+		if( (fstat(d->fd, &st) == 0) && S_ISREG(st.st_mode) &&
+			(ftruncate(d->fd, (off_t)offset) != 0) ) {
+			printf(" --- ERROR truncate '%s'\r\n", d->name);
+		}
+		lseek(d->fd, (off_t)offset, SEEK_SET);
+	}
+}
+
+/**
+ * Подключить файл вывода к устройству, файл начинается с позиции вывода
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t out_open(out_dev_t *d, char *path) {
+
+	out_flush(d);
+	if( io_async ) {
+		out_wait(d);
+	}
+	if( d->fd > STDERR_FILENO ) {
+		close(d->fd);
+	}
+	d->fd = open(path, O_WRONLY | O_CREAT, 0644);
+	if( d->fd < 0 ) {
+		printf(" --- ERROR open '%s'\r\n", path);
+		return -1;
+	}
+	out_seek(d, d->offset);
+	return 0;
+}
+
+/**
+ * Записать кольца всех устройств вывода и дождаться записи
+ */
+void out_flush_all(void) {
+
+	uint8_t i;
+
+	for(i=0; i<OUT_NUMBER_DEVS; i++) {
+		out_flush(&out_dev[i]);
+		if( io_async ) {
+			out_wait(&out_dev[i]);
+		}
+	}
+}
+
+/**
+ * Вывод зоны на перфоленту: 54 коротких слова zone,
+ * снятых с FRAM при постановке обмена, по три строки ленты,
+ * старшие триты первыми.
+ *
+ * Рез:  return=0 - OK', return|=0 - Error или нет перфоратора
+ */
+int8_t ptp_write_zone(void *ctx, uint8_t fz, trishort *zone) {
+
+	out_dev_t *d = ctx;
+	uint8_t buf[SIZE_ZONE_TRIT_DRUM * 3 * (TAPE_TRACKS + 1)];
+	uint8_t i;
+	uint8_t j;
+	uint8_t *p;
+	trishort w;
+	trishort *fp;
+	trs_t v;
+
+	if( d->fd < 0 ) {
+		return -1;
+	}
+	if( !out_room(d, sizeof(buf)) ) {
+		return IO_BUSY;
+	}
+
+	(void)fz;
+	fp = zone;
+	p = buf;
+
+	v.l = 3;
+	for(i=0; i < SIZE_ZONE_TRIT_DRUM; i++) {
+		w = fp[i];
+		for(j=0; j<3; j++) {
+			v.tb = (w >> (6 * (2 - j))) & 0x3F;
+			trit2linetape(v, p);
+			p[TAPE_TRACKS] = '\n';
+			p += TAPE_TRACKS + 1;
+		}
+	}
+
+	out_put(d, buf, sizeof(buf));
+	return 0;
+}
+
+/**
+ * Девятеричная строка слова: 5 цифр и '\n', как в файлах '*.txs'
+ */
+#define NONARY_LINE		(6)
+
+/**
+ * Девятеричная цифра по полю битов двух тритов
+ */
+static const uint8_t lpt_digit[16] = "0Z10XWYX32430Z10";
+
+/**
+ * Поле битов двух тритов по девятеричной цифре плюс 1:
+ * 0 - недопустимый символ
+ */
+static const uint8_t nonary_bits[256] = {
+	['W'] = 0x5 + 1, ['X'] = 0x4 + 1, ['Y'] = 0x6 + 1, ['Z'] = 0x1 + 1,
+	['w'] = 0x5 + 1, ['x'] = 0x4 + 1, ['y'] = 0x6 + 1, ['z'] = 0x1 + 1,
+	['0'] = 0x0 + 1, ['1'] = 0x2 + 1, ['2'] = 0x9 + 1, ['3'] = 0x8 + 1, ['4'] = 0xA + 1
+};
+
+/**
+ * Записать слово w девятеричной строкой
+ */
+static inline void nonary_put(uint8_t *p, trishort w) {
+	p[0] = lpt_digit[(w >> 16) & 0x3];
+	p[1] = lpt_digit[(w >> 12) & 0xF];
+	p[2] = lpt_digit[(w >> 8) & 0xF];
+	p[3] = lpt_digit[(w >> 4) & 0xF];
+	p[4] = lpt_digit[w & 0xF];
+	p[5] = '\n';
+}
+
+/**
+ * Записать слова зоны fp девятеричными строками
+ */
+void nonary_zone(uint8_t *p, trishort *fp) {
+
+	uint8_t i;
+
+	for(i=0; i < SIZE_ZONE_TRIT_DRUM; i++) {
+		nonary_put(p, fp[i]);
+		p += NONARY_LINE;
+	}
+}
+
+/**
+ * Короткое слово по строке из 5 девятеричных цифр
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t nonary_word(uint8_t *p, trishort *w) {
+
+	uint8_t i;
+	uint8_t b;
+	trishort v;
+
+	v = 0;
+	for(i=0; i<5; i++) {
+		b = nonary_bits[p[i]];
+		if( b == 0 ) {
+			return -1;
+		}
+		v = (v << 4) | (b - 1);
+	}
+	*w = v & 0x3FFFF;
+	return 0;
+}
+
+/**
+ * Печать зоны: 54 коротких слова zone, снятых с FRAM при постановке
+ * обмена, по слову в строке 5 девятеричными цифрами, как в файлах '*.txs'.
+ *
+ * Рез:  return=0 - OK', return|=0 - Error или нет печати
+ */
+int8_t lpt_write_zone(void *ctx, uint8_t fz, trishort *zone) {
+
+	out_dev_t *d = ctx;
+	uint8_t buf[SIZE_ZONE_TRIT_DRUM * NONARY_LINE];
+
+	if( d->fd < 0 ) {
+		return -1;
+	}
+	if( !out_room(d, sizeof(buf)) ) {
+		return IO_BUSY;
+	}
+
+	(void)fz;
+	nonary_zone(buf, zone);
+	out_put(d, buf, sizeof(buf));
+	return 0;
+}
+
+/** *********************************************
+ *  Пульт управления up0
+ *  ---------------------------------------------
+ *
+ *  Набор слов на пульте задаётся файлом слов
+ *  в девятеричном виде, по слову в строке.
+ */
+tape_reader_t up_dev = { .name = "up0", .fd = -1 };
+
+/**
+ * Ввод с пульта в зону FRAM fz (0...2) до 54 коротких слов.
+ * Слова после конца набора заполняются нулями.
+ *
+ * Рез:  return=0 - OK', return|=0 - Error или нет набора
+ */
+int8_t up_read_zone(void *ctx, uint8_t fz, trishort *zone) {
+
+	tape_reader_t *t = ctx;
+	uint8_t i;
+	uint8_t *p;
+	uint32_t n;
+	trishort *fp;
+
+	(void)zone;
+	if( !ptr_ready(t) ) {
+		return IO_BUSY;
+	}
+	fp = &mem_fram[fz * (SIZE_PAGE_TRIT_FRAM / 3)][0];
+
+	for(i=0; i < SIZE_ZONE_TRIT_DRUM; i++) {
+		n = ptr_read_line(t, &p);
+		if( n == 0 ) {
+			break;
+		}
+		if( n < 5 || nonary_word(p, &fp[i]) != 0 ) {
+			printf(" --- ERROR word '%s'\r\n", t->name);
+			return -1;
+		}
+	}
+	if( i == 0 ) {
+		return -1; /* нет набора */
+	}
+	memset(&fp[i], 0, (SIZE_ZONE_TRIT_DRUM - i) * sizeof(trishort));
+
+	for(i=0; i < SIZE_PAGE_TRIT_FRAM / 3; i++) {
+		FRAM_TOUCH(fz * (SIZE_PAGE_TRIT_FRAM / 3) + i);
+	}
+	return 0;
+}
+
+/** *********************************************
+ *  Поток ввода-вывода хоста
+ *  ---------------------------------------------
+ */
+static tape_reader_t * const io_readers[] = { &ptr_dev[0], &ptr_dev[1], &up_dev };
+static pthread_t io_thread_id;
+static _Atomic uint8_t io_stop;		/* остановить поток хоста */
+
+/**
+ * Поток хоста: пишет кольца устройств вывода в файлы,
+ * дочитывает файлы устройств ввода в кольца
+ */
+void * io_thread(void *arg) {
+
+	uint8_t i;
+	uint8_t work;
+	uint8_t *p;
+	uint32_t n;
+	ssize_t r;
+	out_dev_t *d;
+	tape_reader_t *t;
+	sigset_t sig;
+
+	(void)arg;
+	/* SIGPROF выборочного профиля принимает только поток машины */
+	sigemptyset(&sig);
+	sigaddset(&sig, SIGPROF);
+	pthread_sigmask(SIG_BLOCK, &sig, NULL);
+	for(;;) {
+		work = 0;
+		for(i=0; i<OUT_NUMBER_DEVS; i++) {
+			d = &out_dev[i];
+			while( (n = ring_data(&d->ring, &p)) > 0 ) {
+				if( d->fd >= 0 ) {
+					out_write(d, p, n);
+				}
+				ring_skip(&d->ring, n);
+				work = 1;
+			}
+		}
+		for(i=0; i < sizeof(io_readers) / sizeof(io_readers[0]); i++) {
+			t = io_readers[i];
+			if( atomic_load(&t->pause) ) {
+				atomic_store(&t->paused, 1);
+				continue;
+			}
+			if( atomic_load(&t->paused) ) {
+				/* Продолжение: сбросить paused и проверить pause снова */
+				atomic_store(&t->paused, 0);
+				if( atomic_load(&t->pause) ) {
+					atomic_store(&t->paused, 1);
+					continue;
+				}
+			}
+			if( t->fd < 0 || atomic_load_explicit(&t->eof, memory_order_relaxed) ) {
+				continue;
+			}
+			if( IO_RING_SIZE - ring_used(&t->ring) < IO_RING_SIZE / 4 ) {
+				continue; /* кольцо почти полное */
+			}
+			n = ring_room(&t->ring, &p);
+			r = read(t->fd, p, n);
+			if( r <= 0 ) {
+				atomic_store_explicit(&t->eof, 1, memory_order_release);
+			}
+			else {
+				ring_commit(&t->ring, (uint32_t)r);
+			}
+			work = 1;
+		}
+		io_pass_done();
+		if( !work ) {
+			if( atomic_load_explicit(&io_stop, memory_order_acquire) ) {
+				break;
+			}
+			sem_wait(&io_sem);
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Запустить поток ввода-вывода хоста
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t io_async_start(void) {
+
+	uint8_t i;
+
+	if( io_async ) {
+		return 0;
+	}
+	out_flush_all();
+	sem_init(&io_sem, 0, 0);
+	atomic_store(&io_stop, 0);
+	io_async = 1;
+	if( pthread_create(&io_thread_id, NULL, io_thread, NULL) != 0 ) {
+		io_async = 0;
+		printf(" --- ERROR start I/O thread\r\n");
+		return -1;
+	}
+	for(i=0; i < sizeof(io_readers) / sizeof(io_readers[0]); i++) {
+		ptr_seek(io_readers[i], io_readers[i]->offset); /* буфер читает хост */
+	}
+	return 0;
+}
+
+/**
+ * Записать кольца, остановить поток хоста, закрыть файлы
+ */
+void out_close_all(void) {
+
+	uint8_t i;
+
+	out_flush_all();
+	if( io_async ) {
+		atomic_store_explicit(&io_stop, 1, memory_order_release);
+		sem_post(&io_sem);
+		pthread_join(io_thread_id, NULL);
+		sem_destroy(&io_sem);
+		io_async = 0;
+	}
+	for(i=0; i<OUT_NUMBER_DEVS; i++) {
+		if( out_dev[i].fd > STDERR_FILENO ) {
+			close(out_dev[i].fd);
+		}
+		out_dev[i].fd = -1;
+	}
+}
+
+/** *********************************************
+ *  Магнитные ленты ur0, ur1
+ *  ---------------------------------------------
+ *
+ *  Лента - файл слов в девятеричном виде, как '*.txs',
+ *  по слову в строке постоянной длины NONARY_LINE.
+ *  Обмен идёт блоками по зоне 54 слова с позиции ленты,
+ *  блок читается и пишется одним pread() или pwrite().
+ */
+typedef struct tape_unit {
+	char *name;				/* имя устройства */
+	int fd;					/* файл ленты */
+	uint64_t offset;		/* позиция ленты в файле */
+} tape_unit_t;
+
+tape_unit_t ur_dev[2] = {
+	{ .name = "ur0", .fd = -1 },
+	{ .name = "ur1", .fd = -1 }
+};
+
+/**
+ * Установить файл ленты на магнитофон
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t ur_open(tape_unit_t *u, char *path) {
+
+	if( u->fd >= 0 ) {
+		close(u->fd);
+	}
+	u->fd = open(path, O_RDWR | O_CREAT, 0644);
+	if( u->fd < 0 ) {
+		printf(" --- ERROR open '%s'\r\n", path);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Чтение блока ленты в зону FRAM fz (0...2).
+ * Слова после конца ленты заполняются нулями.
+ *
+ * Рез:  return=0 - OK', return|=0 - Error или конец ленты
+ */
+int8_t ur_read_zone(void *ctx, uint8_t fz, trishort *zone) {
+
+	tape_unit_t *u = ctx;
+	uint8_t buf[SIZE_ZONE_TRIT_DRUM * NONARY_LINE];
+	uint8_t i;
+	uint8_t n;
+	ssize_t r;
+	trishort *fp;
+
+	(void)zone;
+	if( u->fd < 0 ) {
+		return -1;
+	}
+	r = pread(u->fd, buf, sizeof(buf), (off_t)u->offset);
+	if( r < NONARY_LINE ) {
+		return -1; /* конец ленты */
+	}
+
+	fp = &mem_fram[fz * (SIZE_PAGE_TRIT_FRAM / 3)][0];
+	n = (uint8_t)(r / NONARY_LINE);
+	for(i=0; i<n; i++) {
+		if( buf[i * NONARY_LINE + 5] != '\n' ||
+			nonary_word(&buf[i * NONARY_LINE], &fp[i]) != 0
+		  ) {
+			printf(" --- ERROR tape '%s'\r\n", u->name);
+			return -1;
+		}
+	}
+	memset(&fp[n], 0, (SIZE_ZONE_TRIT_DRUM - n) * sizeof(trishort));
+	u->offset += n * NONARY_LINE;
+
+	for(i=0; i < SIZE_PAGE_TRIT_FRAM / 3; i++) {
+		FRAM_TOUCH(fz * (SIZE_PAGE_TRIT_FRAM / 3) + i);
+	}
+	return 0;
+}
+
+/**
+ * Запись зоны блоком на ленту: 54 коротких слова zone,
+ * снятых с FRAM при постановке обмена
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t ur_write_zone(void *ctx, uint8_t fz, trishort *zone) {
+
+	tape_unit_t *u = ctx;
+	uint8_t buf[SIZE_ZONE_TRIT_DRUM * NONARY_LINE];
+
+	if( u->fd < 0 ) {
+		return -1;
+	}
+	(void)fz;
+	nonary_zone(buf, zone);
+	if( pwrite(u->fd, buf, sizeof(buf), (off_t)u->offset) != (ssize_t)sizeof(buf) ) {
+		printf(" --- ERROR write '%s'\r\n", u->name);
+		return -1;
+	}
+	u->offset += sizeof(buf);
+	return 0;
+}
+
+/**
+ * Печать троичного регистра 
+ *  
+ */
+void view_short_reg(trs_t *t, uint8_t *ch) {
+	 int8_t i;
+	 int8_t l;
+	 trs_t tv;
+	 
+	 tv = *t;
+	 printf("%s: ",(char *)ch);
+	 //printf("%s=%i\t[",ch,tv.l);	 	 	 
+	 if( tv.l <= 0 ) {
+		 //printf("]\n");
+		 return;
+	 }
+	 else if(tv.l > SIZE_WORD_LONG) {
+		 l = SIZE_WORD_LONG;
+	 }
+	 else {
+		 l = tv.l;
+	 }
+	 
+	 printf("[");
+	 i=0;	 
+	 do {
+		  tv = *t;
+		  tv.tb >>= (l-1-i)*2 ; 
+		  printf("%i",trit2bit(tv));          		    		  
+		  //switch(trit2bit(tv)) {
+		  //	  case -1: printf("-"); break;
+		  //	  case  0: printf("0"); break;
+		  //	  case  1: printf("+"); break;
+		  //  }
+		  i++;          
+     } 
+	 while( i < l );
+	 printf("], ");
+	 printf("(%li), ",(long int)trs_to_digit(t));	 
+	 tv = *t;
+	 trit_to_str(tv);	 
+	 printf("\n");
+}
+
+/**
+ * Символ пишущей машинки: байты UTF-8
+ */
+typedef struct tw_char {
+	uint8_t n;		/* количество байт */
+	char s[3];		/* символ UTF-8 */
+} tw_char_t;
+
+/**
+ * Знаки пишущей машинки по коду t = -13...+13:
+ * [код + 13][русский 0, латинский 1][буквы 0, цифры 1].
+ * Код --+ в русском регистре переключает цвет ленты (черный, красный),
+ * коды ++- и ++0 переключают регистр цифр и букв, знаков не печатают.
+ */
+static const tw_char_t tw_tab[27][2][2] = {
+	{ { { 0, "" }, { 0, "" } }, { { 0, "" }, { 0, "" } } },	/* -13 : --- */
+	{ { { 2, "Б" }, { 1, "-" } }, { { 1, "F" }, { 1, "-" } } },	/* -12 : --0 */
+	{ { { 0, "" }, { 0, "" } }, { { 1, "?" }, { 1, "?" } } },	/* -11 : --+ */
+	{ { { 2, "\r\n" }, { 2, "\r\n" } }, { { 2, "\r\n" }, { 2, "\r\n" } } },	/* -10 : -0- */
+	{ { { 2, "Щ" }, { 2, "Ю" } }, { { 1, "G" }, { 1, "/" } } },	/*  -9 : -00 */
+	{ { { 2, "Н" }, { 1, "," } }, { { 1, "H" }, { 1, "." } } },	/*  -8 : -0+ */
+	{ { { 1, "=" }, { 2, "х" } }, { { 1, "=" }, { 1, "x" } } },	/*  -7 : -+- */
+	{ { { 1, "I" }, { 1, "+" } }, { { 2, "Л" }, { 1, "+" } } },	/*  -6 : -+0 */
+	{ { { 2, "Ы" }, { 2, "Э" } }, { { 1, "J" }, { 1, "V" } } },	/*  -5 : -++ */
+	{ { { 2, "К" }, { 2, "Ж" } }, { { 1, "K" }, { 1, "W" } } },	/*  -4 : 0-- */
+	{ { { 2, "Г" }, { 2, "Х" } }, { { 1, "L" }, { 1, "X" } } },	/*  -3 : 0-0 */
+	{ { { 2, "М" }, { 2, "У" } }, { { 1, "M" }, { 1, "Y" } } },	/*  -2 : 0-+ */
+	{ { { 2, "И" }, { 2, "Ц" } }, { { 1, "N" }, { 1, "Z" } } },	/*  -1 : 00- */
+	{ { { 2, "Р" }, { 2, "О" } }, { { 1, "P" }, { 1, "O" } } },	/*   0 : 000 */
+	{ { { 2, "Й" }, { 1, "1" } }, { { 1, "Q" }, { 1, "1" } } },	/*   1 : 00+ */
+	{ { { 2, "Я" }, { 1, "2" } }, { { 1, "R" }, { 1, "2" } } },	/*   2 : 0+- */
+	{ { { 2, "Ь" }, { 1, "3" } }, { { 1, "S" }, { 1, "3" } } },	/*   3 : 0+0 */
+	{ { { 2, "Т" }, { 1, "4" } }, { { 1, "T" }, { 1, "4" } } },	/*   4 : 0++ */
+	{ { { 2, "П" }, { 1, "5" } }, { { 1, "U" }, { 1, "5" } } },	/*   5 : +-- */
+	{ { { 2, "А" }, { 1, "6" } }, { { 1, "A" }, { 1, "6" } } },	/*   6 : +-0 */
+	{ { { 2, "В" }, { 1, "7" } }, { { 1, "B" }, { 1, "7" } } },	/*   7 : +-+ */
+	{ { { 2, "С" }, { 1, "8" } }, { { 1, "C" }, { 1, "8" } } },	/*   8 : +0- */
+	{ { { 2, "Д" }, { 1, "9" } }, { { 1, "D" }, { 1, "9" } } },	/*   9 : +00 */
+	{ { { 2, "Е" }, { 1, " " } }, { { 1, "E" }, { 1, " " } } },	/*  10 : +0+ */
+	{ { { 0, "" }, { 0, "" } }, { { 0, "" }, { 0, "" } } },	/*  11 : ++- */
+	{ { { 0, "" }, { 0, "" } }, { { 0, "" }, { 0, "" } } },	/*  12 : ++0 */
+	{ { { 2, "Ш" }, { 2, "Ф" } }, { { 1, "(" }, { 1, ")" } } },	/*  13 : +++ */
+};
+
+/**
+ * Печать на электрифицированную пишущую машинку
+ * 'An electrified typewriter'
+ *
+ * Знак по таблице записывается в буфер устройства tty0.
+ */
+void electrified_typewriter(trs_t t, uint8_t local) {
+
+	int32_t code;
+	const tw_char_t *c;
+
+	russian_latin_sw = local;
+	code = trs_to_digit(&t);
+
+	switch( code ) {
+		case 12: /* t = ++0, регистр букв */
+			letter_number_sw = 0;
+			return;
+		case 11: /* t = ++-, регистр цифр */
+			letter_number_sw = 1;
+			return;
+		default:
+			break;
+	}
+	if( code < -13 || code > 13 ) {
+		return;
+	}
+
+	c = &tw_tab[code + 13][russian_latin_sw != 0][letter_number_sw != 0];
+	if( c->n == 0 ) {
+		return;
+	}
+	out_put(&out_dev[OUT_TTY0], (const uint8_t *)c->s, c->n);
+}
+
+/**
+ * Печать зоны на пишущей машинке: 54 коротких слова zone,
+ * снятых с FRAM при постановке обмена, по три кода, старшие триты первыми.
+ *
+ * Рез:  return=0 - OK'
+ */
+int8_t tty_write_zone(void *ctx, uint8_t fz, trishort *zone) {
+
+	uint8_t i;
+	uint8_t j;
+	trishort w;
+	trishort *fp;
+	trs_t v;
+
+	(void)ctx;
+	(void)fz;
+	fp = zone;
+
+	v.l = 3;
+	for(i=0; i < SIZE_ZONE_TRIT_DRUM; i++) {
+		w = fp[i];
+		for(j=0; j<3; j++) {
+			v.tb = (w >> (6 * (2 - j))) & 0x3F;
+			electrified_typewriter(v, russian_latin_sw);
+		}
+	}
+	return 0;
+}
+
+/** *********************************************
+ *  Ввод-вывод операции -00
+ *  ---------------------------------------------
+ *
+ *  A*(1:4) - номер устройства -40...+40, A*(5) - зона FRAM Фа*.
+ *  Положительные номера - ввод в Фа*, отрицательные - вывод из Фа*.
+ *
+ *  Устройства регистрируются в таблице по номеру. Операция -00
+ *  только ставит обмен устройству, обмен зоной выполняется
+ *  по времени машины, когда cycles достигает done устройства.
+ *  Обмен с занятым устройством ждёт окончания предыдущего.
+ *  Вывод берёт слова зоны на момент операции -00: запись в зону
+ *  во время обмена не меняет выводимые данные.
+ *  Без модели времени устройств `--io-timing` обмен заканчивается
+ *  до следующей операции, как синхронный ввод-вывод.
+ */
+#define DEV_SEL_PTR0	(1)		/* фотосчитыватель 0, A*(1:4) = 000+ */
+#define DEV_SEL_PTR1	(2)		/* фотосчитыватель 1, A*(1:4) = 00+- */
+#define DEV_SEL_UP0		(3)		/* пульт, A*(1:4) = 00+0 */
+#define DEV_SEL_UR0_RD	(4)		/* чтение ленты ur0, A*(1:4) = 00++ */
+#define DEV_SEL_UR1_RD	(5)		/* чтение ленты ur1, A*(1:4) = 0+-- */
+#define DEV_SEL_PTP0	(-1)	/* перфоратор, A*(1:4) = 000- */
+#define DEV_SEL_LPT0	(-2)	/* печать, A*(1:4) = 00-+ */
+#define DEV_SEL_TTY0	(-3)	/* пишущая машинка, A*(1:4) = 00-0 */
+#define DEV_SEL_UR0_WR	(-4)	/* запись ленты ur0, A*(1:4) = 00-- */
+#define DEV_SEL_UR1_WR	(-5)	/* запись ленты ur1, A*(1:4) = 0-++ */
+
+#define DEV_SEL_MAX		(40)	/* номера устройств -40...+40 */
+#define DEV_NUMBER		(16)	/* мест в таблице устройств */
+
+/**
+ * Время обмена зоной 54 слова, такты 1 мкс
+ */
+#define IO_TIME_PTR		(SIZE_ZONE_TRIT_DRUM * 3 * 1250)	/* 800 строк ленты/с */
+#define IO_TIME_PTP		(SIZE_ZONE_TRIT_DRUM * 3 * 12500)	/* 80 строк ленты/с */
+#define IO_TIME_LPT		(SIZE_ZONE_TRIT_DRUM * 50000)		/* 20 строк печати/с */
+#define IO_TIME_TTY		(SIZE_ZONE_TRIT_DRUM * 3 * 142857)	/* 7 знаков/с */
+#define IO_TIME_UP		(0)									/* набор готов до пуска */
+#define IO_TIME_UR		(SIZE_ZONE_TRIT_DRUM * 1000)		/* блок магнитной ленты */
+
+/* Обмен зоной FRAM fz, для вывода - словами zone, снятыми при постановке обмена */
+typedef int8_t (*io_xfer_fn)(void *ctx, uint8_t fz, trishort *zone);
+
+/**
+ * Описание устройства машины для регистрации
+ */
+typedef struct io_desc {
+	char *name;			/* имя устройства */
+	int8_t sel;			/* номер A*(1:4) */
+	io_xfer_fn xfer;	/* обмен зоной FRAM */
+	void *ctx;			/* состояние устройства */
+	uint32_t time;		/* время обмена зоной, такты */
+} io_desc_t;
+
+typedef struct io_dev {
+	char *name;			/* имя устройства */
+	int8_t sel;			/* номер A*(1:4) */
+	io_xfer_fn xfer;	/* обмен зоной FRAM */
+	void *ctx;			/* состояние устройства */
+	uint32_t time;		/* время обмена зоной, такты */
+	uint8_t busy;		/* обмен поставлен */
+	uint8_t fz;			/* зона FRAM обмена */
+	uint64_t done;		/* время окончания обмена */
+	trishort zone[SIZE_ZONE_TRIT_DRUM];	/* слова зоны вывода при постановке обмена */
+} io_dev_t;
+
+/**
+ * Устройства машины
+ */
+static const io_desc_t io_builtin[] = {
+	{ "ptr0",   DEV_SEL_PTR0,   ptr_read_zone,  &ptr_dev[0],        IO_TIME_PTR },
+	{ "ptr1",   DEV_SEL_PTR1,   ptr_read_zone,  &ptr_dev[1],        IO_TIME_PTR },
+	{ "up0",    DEV_SEL_UP0,    up_read_zone,   &up_dev,            IO_TIME_UP  },
+	{ "ur0 rd", DEV_SEL_UR0_RD, ur_read_zone,   &ur_dev[0],         IO_TIME_UR  },
+	{ "ur1 rd", DEV_SEL_UR1_RD, ur_read_zone,   &ur_dev[1],         IO_TIME_UR  },
+	{ "ptp0",   DEV_SEL_PTP0,   ptp_write_zone, &out_dev[OUT_PTP0], IO_TIME_PTP },
+	{ "lpt0",   DEV_SEL_LPT0,   lpt_write_zone, &out_dev[OUT_LPT0], IO_TIME_LPT },
+	{ "tty0",   DEV_SEL_TTY0,   tty_write_zone, &out_dev[OUT_TTY0], IO_TIME_TTY },
+	{ "ur0 wr", DEV_SEL_UR0_WR, ur_write_zone,  &ur_dev[0],         IO_TIME_UR  },
+	{ "ur1 wr", DEV_SEL_UR1_WR, ur_write_zone,  &ur_dev[1],         IO_TIME_UR  }
+};
+
+io_dev_t io_devs[DEV_NUMBER];					/* зарегистрированные устройства */
+uint8_t io_count = 0;							/* количество устройств */
+static io_dev_t *io_tab[2 * DEV_SEL_MAX + 1];	/* устройство по номеру A*(1:4) */
+uint8_t io_timing = 0;							/* учитывать время обмена устройств */
+
+/**
+ * Зарегистрировать устройство с номером sel
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t io_register(char *name, int8_t sel, io_xfer_fn xfer, void *ctx, uint32_t time) {
+
+	io_dev_t *d;
+
+	if( io_count >= DEV_NUMBER || sel < -DEV_SEL_MAX || sel > DEV_SEL_MAX ||
+		io_tab[sel + DEV_SEL_MAX] != NULL
+	  ) {
+		printf(" --- ERROR register '%s'\r\n", name);
+		return -1;
+	}
+	d = &io_devs[io_count++];
+	memset(d, 0, sizeof(io_dev_t));
+	d->name = name;
+	d->sel  = sel;
+	d->xfer = xfer;
+	d->ctx  = ctx;
+	d->time = time;
+	io_tab[sel + DEV_SEL_MAX] = d;
+	return 0;
+}
+
+/**
+ * Сброс таблицы устройств: устройства машины без обменов
+ */
+void io_reset(void) {
+
+	uint8_t i;
+
+	memset(io_tab, 0, sizeof(io_tab));
+	io_count = 0;
+	event_clear();
+	for(i=0; i < sizeof(io_builtin) / sizeof(io_builtin[0]); i++) {
+		io_register(io_builtin[i].name, io_builtin[i].sel, io_builtin[i].xfer,
+					io_builtin[i].ctx, io_builtin[i].time);
+	}
+}
+
+int8_t io_done(void *ctx);
+
+/**
+ * Поставить событие окончания обмена устройства
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t io_post(io_dev_t *d) {
+	return event_post(d->done, (uint8_t)(d - io_devs), io_done, d);
+}
+
+/**
+ * Окончание обмена устройства: событие очереди
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t io_done(void *ctx) {
+
+	io_dev_t *d = ctx;
+	int8_t r;
+
+	r = d->xfer(d->ctx, d->fz, d->zone);
+	if( r == IO_BUSY ) {
+		/* Хост не успевает: устройство остаётся занятым */
+		d->done = cycles + IO_RETRY_TIME;
+		io_wake();
+		return io_post(d);
+	}
+	d->busy = 0;
+	io_wake();
+	if( (d->sel > 0) && vcd_on ) {
+		vcd_fram_zone(d->fz); /* ввод записал зону FRAM */
+	}
+	if( r != 0 ) {
+		printf(" --- ERROR I/O '%s'\r\n", d->name);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Дождаться окончания всех обменов
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t io_drain(void) {
+
+	int8_t r;
+
+	r = 0;
+	while( event_count > 0 ) {
+		if( event_wait(event_next) != 0 ) {
+			r = -1;
+		}
+	}
+	return r;
+}
+
+/**
+ * Дождаться окончания обменов устройств с зоной FRAM fz
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t io_wait_zone(uint8_t fz) {
+
+	uint8_t i;
+	uint8_t w;
+	uint64_t t;
+
+	do {
+		w = 0;
+		t = cycles;
+		for(i=0; i<io_count; i++) {
+			if( io_devs[i].busy && io_devs[i].fz == fz ) {
+				if( io_devs[i].done > t ) {
+					t = io_devs[i].done;
+				}
+				w = 1;
+			}
+		}
+		if( w && event_wait(t) != 0 ) {
+			return -1;
+		}
+	} while( w );
+	return 0;
+}
+
+/**
+ * Установить обмены устройств из образа
+ */
+void io_state_set(const uint8_t *busy, const uint8_t *fz, const uint64_t *done,
+				  trishort (*zone)[SIZE_ZONE_TRIT_DRUM]) {
+
+	uint8_t i;
+
+	event_clear();
+	for(i=0; i<io_count; i++) {
+		io_devs[i].busy = busy[i];
+		io_devs[i].fz   = fz[i];
+		io_devs[i].done = done[i];
+		memcpy(io_devs[i].zone, zone[i], SIZE_ZONE_BYTES);
+		if( busy[i] ) {
+			io_post(&io_devs[i]);
+		}
+	}
+}
+
+/**
+ * Поставить обмен с устройством по адресу A*
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t io_xfer( trs_t a ) {
+
+	trs_t sel;
+	io_dev_t *d;
+
+	samp_phase = SAMP_DEVICE;
+	sel = slice_trs(a,1,4);
+	d = io_tab[trs_to_digit(&sel) + DEV_SEL_MAX];
+	if( d == NULL ) {
+		return -1; /* нет устройства */
+	}
+
+	while( d->busy ) {
+		/* Устройство занято: ожидание окончания обмена */
+		if( event_wait(d->done) != 0 ) {
+			return -1;
+		}
+	}
+
+	d->fz   = (uint8_t)(get_trit_int(a,5) + 1);
+	if( io_wait_zone(d->fz) != 0 ) {
+		return -1; /* зона занята обменом другого устройства */
+	}
+	if( d->sel < 0 ) {
+		/* Вывод: слова зоны на момент операции -00 */
+		memcpy(d->zone, &mem_fram[d->fz * (SIZE_PAGE_TRIT_FRAM / 3)][0], SIZE_ZONE_BYTES);
+	}
+	d->done = cycles + (io_timing ? d->time : 0);
+	d->busy = 1;
+	vm_stat.io++;
+	return io_post(d);
+}
+
+/**
+ * Печать регистров машины Сетунь-1958 
+ */
+void view_short_regs(void) {
+	int8_t i;
+
+	printf("[ Registers Setun-1958: ]\n");
+
+	view_short_reg(&K," K");
+	view_short_reg(&F," F");	
+	view_short_reg(&C," C");
+	view_short_reg(&W," W");
+	view_short_reg(&S," S");	
+	view_short_reg(&R," R");
+	view_short_reg(&MB," MB");
+}
+
+/** *********************************************
+ *  Дизассемблер и печать слов памяти
+ *  ---------------------------------------------
+ *
+ *  Строки печати собираются в буфере без printf:
+ *  операция с адресом A(1:5) и признаком K(9) как в тексте
+ *  ассемблера, девятеричный и десятичный вид слова.
+ *  Печать памяти выводится блоками одной операцией fwrite().
+ */
+#define DIS_BUF_SIZE	(65536)	/* буфер печати */
+#define DIS_LINE		(160)	/* наибольшая строка печати */
+
+/**
+ * Мнемоники операций по коду K(6:8) + 13, NULL - не задействована
+ */
+const char *op_names[27] = {
+	NULL,   NULL,  NULL,   "DRD",  "IO",   "DWR",  "NORM", "SHIFT", "STS",
+	"ADDF", "LDF", "ADCF", "STF",  "JMP",  "STC",  "JN",   "JZ",    "JP",
+	"STOP", "AND", "LDR",  "SUB",  "LDS",  "ADD",  "MULM", "MUL0",  "MULP"
+};
+
+static char dis_buf[DIS_BUF_SIZE];	/* буфер печати памяти */
+
+/**
+ * Строка s
+ */
+static inline char * dis_str(char *p, const char *s) {
+	while( *s ) {
+		*p++ = *s++;
+	}
+	return p;
+}
+
+/**
+ * Десятичное число v по правому краю поля w,
+ * sp - пробел перед неотрицательным числом как в "% i"
+ */
+char * dis_int(char *p, int64_t v, uint8_t w, uint8_t sp) {
+
+	char d[24];
+	uint8_t n;
+	uint64_t u;
+
+	u = (v < 0) ? -(uint64_t)v : (uint64_t)v;
+	n = 0;
+	do {
+		d[n++] = '0' + u % 10;
+		u /= 10;
+	} while( u != 0 );
+	if( v < 0 ) {
+		d[n++] = '-';
+	}
+	else if( sp ) {
+		d[n++] = ' ';
+	}
+	while( w > n ) {
+		*p++ = ' ';
+		w--;
+	}
+	while( n ) {
+		*p++ = d[--n];
+	}
+	return p;
+}
+
+/**
+ * Поле битов слова: "0x" и 6 шестнадцатеричных цифр
+ */
+char * dis_hex(char *p, trishort w) {
+
+	int8_t i;
+
+	*p++ = '0';
+	*p++ = 'x';
+	for(i=5; i>=0; i--) {
+		*p++ = "0123456789abcdef"[(w >> (i*4)) & 0xF];
+	}
+	return p;
+}
+
+/**
+ * Триты слова числами 1, 0, -1
+ */
+char * dis_trits_int(char *p, trishort w) {
+
+	int8_t i;
+	int8_t t;
+
+	for(i=8; i>=0; i--) {
+		t = tb2int(w >> (i*2));
+		if( t < 0 ) {
+			*p++ = '-';
+		}
+		*p++ = (t != 0) ? '1' : '0';
+	}
+	return p;
+}
+
+/**
+ * Триты поля битов tb длиной n знаками '-', '0', '+'
+ */
+char * dis_trits(char *p, trilong tb, uint8_t n) {
+
+	while( n-- ) {
+		*p++ = "0-+0"[(tb >> (n*2)) & 3];
+	}
+	return p;
+}
+
+/**
+ * Слово из 5 девятеричных цифр
+ */
+static inline char * dis_nonary(char *p, trishort w) {
+	p[0] = lpt_digit[(w >> 16) & 0x3];
+	p[1] = lpt_digit[(w >> 12) & 0xF];
+	p[2] = lpt_digit[(w >> 8) & 0xF];
+	p[3] = lpt_digit[(w >> 4) & 0xF];
+	p[4] = lpt_digit[w & 0xF];
+	return p + 5;
+}
+
+/**
+ * Операция слова w в виде текста ассемблера: "LDS   %-0-0-, +F"
+ */
+char * dis_oper(char *p, trishort w) {
+
+	const char *name;
+	int8_t code;
+	int8_t k9;
+	char *q;
+
+	code = tb2int(w >> 6) * 9 + tb2int(w >> 4) * 3 + tb2int(w >> 2);
+	name = op_names[code + 13];
+	if( name == NULL ) {
+		p = dis_str(p, ".word #");
+		return dis_nonary(p, w);
+	}
+	q = p + 6;
+	p = dis_str(p, name);
+	while( p < q ) {
+		*p++ = ' ';
+	}
+	*p++ = '%';
+	p = dis_trits(p, w >> 8, 5);
+	k9 = tb2int(w);
+	if( k9 != 0 ) {
+		p = dis_str(p, (k9 > 0) ? ", +F" : ", -F");
+	}
+	return p;
+}
+
+/**
+ * Строка печати слова FRAM
+ */
+char * dis_fram_line(char *p, uint8_t row, uint8_t zone) {
+
+	trishort r;
+
+	r = mem_fram[row][zone];
+	p = dis_str(p, "ram[...] (");
+	p = dis_int(p, row - SIZE_PAGE_TRIT_FRAM/2, 3, 0);
+	*p++ = ':';
+	p = dis_int(p, zone, 2, 0);
+	p = dis_str(p, ") =  hex = ");
+	p = dis_hex(p, r);
+	p = dis_str(p, " [");
+	p = dis_trits_int(p, r);
+	p = dis_str(p, "], (");
+	p = dis_int(p, tb_to_digit(r), 0, 0);
+	p = dis_str(p, "), ");
+	p = dis_nonary(p, r);
+	p = dis_str(p, "  ");
+	p = dis_oper(p, r);
+	*p++ = '\n';
+	return p;
+}
+
+/**
+ * Строка печати слова DRUM
+ */
+char * dis_drum_line(char *p, uint8_t zone, uint8_t row) {
+
+	trishort r;
+
+	r = mem_drum[zone][row];
+	p = dis_str(p, "drum[");
+	p = dis_int(p, zone*SIZE_ZONE_TRIT_DRUM + row, 4, 1);
+	p = dis_str(p, "]  (");
+	p = dis_int(p, zone - 36, 3, 0);
+	*p++ = ':';
+	p = dis_int(p, row - 26, 3, 0);
+	p = dis_str(p, ") = [");
+	p = dis_trits_int(p, r);
+	p = dis_str(p, "], (");
+	p = dis_int(p, tb_to_digit(r), 0, 0);
+	p = dis_str(p, "),\t");
+	p = dis_nonary(p, r);
+	p = dis_str(p, "  ");
+	p = dis_oper(p, r);
+	*p++ = '\n';
+	return p;
+}
+
+/**
+ * Строка трассы операции: адрес A* тритами и числом
+ */
+char * dis_trace(char *p, trs_t a) {
+	p = dis_str(p, "A*=[");
+	p = dis_trits(p, a.tb, 5);
+	p = dis_str(p, "], (");
+	p = dis_int(p, trs_to_digit(&a), 4, 1);
+	return dis_str(p, "), ");
+}
+
+/**
+ * Вывести буфер печати
+ */
+static inline void dis_flush(char *p) {
+	fwrite(dis_buf, 1, p - dis_buf, stdout);
+}
+
+/**
+ * Печать слова FRAM по адресу ea
+ */
+void view_fram(trs_t ea) {
+
+	trs_t zr;
+	trs_t rr;
+	char line[DIS_LINE];
+
+	/* Зона памяти FRAM */
+	zr = slice_trs(ea,5,5);
+	zr.l = 1;
+
+	/* Индекс строки в зоне памяти FRAM */
+	rr = slice_trs(ea,1,4);
+	rr.l = 4;
+
+	fwrite(line, 1, dis_fram_line(line, row_fram_to_index(rr), zone_fram_to_index(zr)) - line, stdout);
+}
+
+void dumpf( trs_t addr1, trs_t addr2) {
+	
+	trs_t ad1 = addr1;
+	trs_t ad2 = addr2;
+	int16_t a1 = trs_to_digit(&ad1);
+	int16_t a2 = trs_to_digit(&ad2);
+	//printf(" a1,a1 = %d", );
+
+	if( (a2 >= a1) && ( a2 >= ZONE_M_FRAM_BEG && a2 <= ZONE_P_FRAM_END ) && ( a2 >= ZONE_M_FRAM_BEG && a2 <= ZONE_P_FRAM_END ) ) {		
+		for( uint16_t i=0; i<(abs(a2-a1)); i++ ) {
+			if( trit2bit(ad1)>=0 ) {
+				view_fram(ad1);
+			}
+			inc_trs(&ad1);
+			if( trit2bit(ad1)<0 ) {
+				inc_trs(&ad1);
+				i += 1;
+			}
+		}
+	}
+}
+
+/**
+ * Печать слова памяти FRAM машины Сетунь-1958 
+ */
+void dump_fram_word(int8_t row, int8_t zone) {
+
+	char line[DIS_LINE];
+
+	fwrite(line, 1, dis_fram_line(line, row, zone) - line, stdout);
+}
+
+/**
+ * Печать слова памяти DRUM машины Сетунь-1958 
+ */
+void dump_drum_word(int8_t zone, int8_t row) {
+
+	char line[DIS_LINE];
+
+	fwrite(line, 1, dis_drum_line(line, zone, row) - line, stdout);
+}
+
+/**
+ * Печать памяти FRAM машины Сетунь-1958 
+ */
+void dump_fram(void) {
+	
+	int8_t zone;
+	int8_t row;
+	char *p;
+
+	printf("\r\n[ Dump FRAM Setun-1958: ]\r\n");
+
+	p = dis_buf;
+	for(row=0; row < SIZE_PAGE_TRIT_FRAM; row++) {
+		for(zone=0; zone < SIZE_PAGES_FRAM; zone++) {
+			if( p > dis_buf + DIS_BUF_SIZE - DIS_LINE ) {
+				dis_flush(p);
+				p = dis_buf;
+			}
+			p = dis_fram_line(p, row, zone);
+		}
+	}
+	dis_flush(p);
+}
+
+/**
+ * Печать памяти DRUM машины Сетунь-1958 
+ */
+void dump_drum(void) {
+
+	int8_t zone;
+	int8_t row;
+	char *p;
+
+	p = dis_buf;
+	for(zone=0; zone < NUMBER_ZONE_DRUM; zone++) {
+		for(row=0; row < SIZE_ZONE_TRIT_DRUM; row++) {
+			if( p > dis_buf + DIS_BUF_SIZE - DIS_LINE ) {
+				dis_flush(p);
+				p = dis_buf;
+			}
+			p = dis_drum_line(p, zone, row);
+		}
+	}
+	dis_flush(p);
+}
+
+/** *********************************************
+ *  Временные диаграммы VCD
+ *  ---------------------------------------------
+ *
+ *  Регистры K, F, C, W, S, R, MB полями битов (2 бита на трит),
+ *  записи в FRAM (адрес, короткое или длинное слово) и зоны барабана по времени машины
+ *  в тактах 1 мкс. Пишутся только изменившиеся сигналы и только
+ *  для операций в окне [vcd_from, vcd_to). Строки собираются в
+ *  буфере и выводятся блоками; без --vcd цикл машины проверяет
+ *  один признак.
+ */
+#define VCD_BUF_SIZE	(1 << 20)	/* буфер записи */
+#define VCD_REGS		(7)			/* регистров в диаграмме */
+
+static int vcd_fd = -1;
+static char vcd_buf[VCD_BUF_SIZE];
+static uint32_t vcd_n = 0;
+uint64_t vcd_from = 0;					/* первая операция окна */
+uint64_t vcd_to = UINT64_MAX;			/* операция после окна */
+static uint64_t vcd_t = UINT64_MAX;		/* время последней отметки */
+static trilong vcd_last[VCD_REGS];		/* записанные значения регистров */
+static uint8_t vcd_dumped = 0;			/* 1 - начальные значения записаны */
+
+static trs_t * const vcd_regs[VCD_REGS] = { &K, &F, &C, &W, &S, &R, &MB };
+static const char vcd_ids[VCD_REGS] = { 'K', 'F', 'C', 'W', 'S', 'R', 'M' };
+static const char *vcd_names[VCD_REGS] = { "K", "F", "C", "W", "S", "R", "MB" };
+static const uint8_t vcd_width[VCD_REGS] = { 9, 5, 5, 1, 18, 18, 4 };	/* тритов */
+
+/**
+ * Вывести буфер записи
+ */
+void vcd_flush(void) {
+
+	uint32_t i;
+	ssize_t r;
+
+	for(i=0; i<vcd_n; i+=r) {
+		r = write(vcd_fd, vcd_buf + i, vcd_n - i);
+		if( r <= 0 ) {
+			printf(" --- ERROR write vcd\r\n");
+			break;
+		}
+	}
+	vcd_n = 0;
+}
+
+/**
+ * Место для строки в буфере записи
+ */
+static inline char * vcd_room(void) {
+	if( vcd_n > VCD_BUF_SIZE - DIS_LINE ) {
+		vcd_flush();
+	}
+	return vcd_buf + vcd_n;
+}
+
+/**
+ * Значение сигнала id: "b<n бит> id"
+ */
+static inline void vcd_bits(trilong v, uint8_t n, char id) {
+
+	char *p;
+
+	p = vcd_room();
+	*p++ = 'b';
+	while( n-- ) {
+		*p++ = '0' + ((v >> n) & 1);
+	}
+	*p++ = ' ';
+	*p++ = id;
+	*p++ = '\n';
+	vcd_n = p - vcd_buf;
+}
+
+/**
+ * Отметка времени машины, если время изменилось
+ */
+static inline void vcd_time(void) {
+
+	char *p;
+
+	if( vcd_t == cycles ) {
+		return;
+	}
+	vcd_t = cycles;
+	p = vcd_room();
+	*p++ = '#';
+	p = dis_int(p, cycles, 0, 0);
+	*p++ = '\n';
+	vcd_n = p - vcd_buf;
+}
+
+/**
+ * Событие id
+ */
+static inline void vcd_event(char id) {
+
+	char *p;
+
+	p = vcd_room();
+	*p++ = '1';
+	*p++ = id;
+	*p++ = '\n';
+	vcd_n = p - vcd_buf;
+}
+
+/**
+ * Открыть файл диаграмм и записать описание сигналов
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t vcd_open(char *path) {
+
+	uint8_t i;
+	int n;
+
+	vcd_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if( vcd_fd < 0 ) {
+		printf(" --- ERROR open '%s'\r\n", path);
+		return -1;
+	}
+	n = sprintf(vcd_buf, "$version emusetun $end\n$timescale 1us $end\n$scope module setun $end\n");
+	for(i=0; i<VCD_REGS; i++) {
+		n += sprintf(vcd_buf + n, "$var wire %d %c %s $end\n",
+					 2 * vcd_width[i], vcd_ids[i], vcd_names[i]);
+	}
+	n += sprintf(vcd_buf + n,
+				 "$var wire 10 a fram_addr $end\n"
+				 "$var wire 36 d fram_data $end\n"
+				 "$var event 1 w fram_wr $end\n"
+				 "$var wire 7 z drum_zone $end\n"
+				 "$var event 1 x drum_wr $end\n"
+				 "$var wire 2 f fram_zone $end\n"
+				 "$var event 1 y fram_zone_wr $end\n"
+				 "$upscope $end\n$enddefinitions $end\n");
+	vcd_n = n;
+	vcd_t = UINT64_MAX;
+	vcd_dumped = 0;
+	return 0;
+}
+
+/**
+ * Изменившиеся регистры после операции,
+ * при первом вызове начальные значения всех сигналов
+ */
+void vcd_step(void) {
+
+	uint8_t i;
+	trilong v;
+
+	vcd_time();
+	if( !vcd_dumped ) {
+		vcd_bits(0, 10, 'a');
+		vcd_bits(0, 36, 'd');
+		vcd_bits(0, 7, 'z');
+		vcd_bits(0, 2, 'f');
+	}
+	for(i=0; i<VCD_REGS; i++) {
+		/* Регистр длиннее своей разрядности: старшие триты */
+		v = vcd_regs[i]->tb;
+		if( vcd_regs[i]->l > vcd_width[i] ) {
+			v >>= 2 * (vcd_regs[i]->l - vcd_width[i]);
+		}
+		v &= ((trilong)1 << (2 * vcd_width[i])) - 1;
+		if( !vcd_dumped || (v != vcd_last[i]) ) {
+			vcd_last[i] = v;
+			vcd_bits(v, 2 * vcd_width[i], vcd_ids[i]);
+		}
+	}
+	vcd_dumped = 1;
+}
+
+/**
+ * Признак записи для следующей операции по окну операций
+ */
+static inline void vcd_window(void) {
+	vcd_on = (opers_count >= vcd_from) && (opers_count < vcd_to);
+	if( vcd_on && !vcd_dumped ) {
+		vcd_step();
+	}
+}
+
+/**
+ * Запись слова v в FRAM по адресу ea
+ */
+void vcd_fram(trs_t ea, trs_t v) {
+	vcd_time();
+	vcd_bits(ea.tb, 10, 'a');
+	vcd_bits(v.tb, (v.l > 9) ? 36 : 18, 'd');
+	vcd_event('w');
+}
+
+/**
+ * Запись зоны барабана с индексом zone
+ */
+void vcd_drum(uint8_t zone) {
+	vcd_time();
+	vcd_bits(zone, 7, 'z');
+	vcd_event('x');
+}
+
+/**
+ * Запись зоны FRAM fz (0...2) целиком: ввод с барабана или устройства
+ */
+void vcd_fram_zone(uint8_t fz) {
+	vcd_time();
+	vcd_bits(fz, 2, 'f');
+	vcd_event('y');
+}
+
+/**
+ * Закрыть файл диаграмм
+ */
+void vcd_close(void) {
+	if( vcd_fd < 0 ) {
+		return;
+	}
+	vcd_flush();
+	close(vcd_fd);
+	vcd_fd = -1;
+	vcd_on = 0;
+}
+
+/** *********************************************
+ *  Изменения памяти после отметки состояния
+ *  ---------------------------------------------
+ */
+trishort fram_at_mark[SIZE_PAGE_TRIT_FRAM][SIZE_PAGES_FRAM]; /* FRAM при отметке */
+trishort drum_at_mark[NUMBER_ZONE_DRUM][SIZE_ZONE_TRIT_DRUM]; /* DRUM при отметке */
+
+/**
+ * Отметить состояние памяти FRAM и DRUM
+ */
+void mem_mark(void) {
+
+	uint8_t z;
+
+	memcpy(fram_at_mark, mem_fram, sizeof(mem_fram));
+	for(z=0; z < NUMBER_ZONE_DRUM; z++) {
+		memcpy(drum_at_mark[z], mem_drum[z], SIZE_ZONE_BYTES);
+	}
+	fram_mark[0] = fram_mark[1] = 0;
+	drum_mark[0] = drum_mark[1] = 0;
+}
+
+/**
+ * Строки FRAM и зоны DRUM с записью после отметки
+ *
+ * Рез:  fram, drum - битовые карты строк и зон
+ *       return - количество строк и зон
+ */
+uint16_t mem_changed(uint64_t *fram, uint64_t *drum) {
+
+	fram[0] = fram_mark[0];
+	fram[1] = fram_mark[1];
+	drum[0] = drum_mark[0];
+	drum[1] = drum_mark[1];
+
+	return __builtin_popcountll(fram[0]) + __builtin_popcountll(fram[1]) +
+		   __builtin_popcountll(drum[0]) + __builtin_popcountll(drum[1]);
+}
+
+/**
+ * Печать слов FRAM изменённых после отметки
+ */
+void dump_fram_changed(void) {
+
+	int8_t zone;
+	int8_t row;
+	uint64_t fram[2];
+	uint64_t drum[2];
+
+	mem_changed(fram,drum);
+
+	printf("\r\n[ Changed FRAM Setun-1958: ]\r\n");
+
+	for(row=0; row < SIZE_PAGE_TRIT_FRAM; row++) {
+		if( !BITS_GET(fram,row) ) {
+			continue;
+		}
+		for(zone=0; zone < SIZE_PAGES_FRAM; zone++) {
+			if( mem_fram[row][zone] != fram_at_mark[row][zone] ) {
+				dump_fram_word(row,zone);
+			}
+		}
+	}
+}
+
+/**
+ * Печать слов DRUM изменённых после отметки
+ */
+void dump_drum_changed(void) {
+
+	int8_t zone;
+	int8_t row;
+	uint64_t fram[2];
+	uint64_t drum[2];
+
+	mem_changed(fram,drum);
+
+	printf("\r\n[ Changed DRUM Setun-1958: ]\r\n");
+
+	for(zone=0; zone < NUMBER_ZONE_DRUM; zone++) {
+		if( !BITS_GET(drum,zone) ) {
+			continue;
+		}
+		for(row=0; row < SIZE_ZONE_TRIT_DRUM; row++) {
+			if( mem_drum[zone][row] != drum_at_mark[zone][row] ) {
+				dump_drum_word(zone,row);
+			}
+		}
+	}
+}
+
+/** *******************************************
+ *  Реалиазция виртуальной машины "Сетунь-1958"
+ *  -------------------------------------------
+ */
+
+/** 
+ * Аппаратный сброс.
+ * Очистить память и регистры
+ * виртуальной машины "Сетунь-1958"
+ */
+void reset_setun_1958(void) {
+	// 
+	clean_fram();	/* Очистить  FRAM */
+	clean_drum();	/* Очистить  DRUM */
+	//
+	clear(&K);		/* K(1:9) */
+	K.l = 9;
+	clear(&F);		/* F(1:5) */
+	F.l = 5;
+	clear(&C);		/* K(1:5) */
+	C.l = 5;
+	clear(&W);		/* W(1:1) */
+	W.l = 1;  					
+	//	
+	clear(&S);		/* S(1:18) */
+	S.l = 18;  
+	clear(&R);		/* R(1:18) */
+	R.l = 18;  				
+	clear(&MB);		/* MB(1:4) */
+	MB.l = 4;  				
+	//
+	clear(&MR);		/* Временный регистр данных MR(1:9) */
+	MR.l = 9;
+	//
+	io_reset();		/* Устройства ввода-вывода */
+	memset(&vm_stat, 0, sizeof(vm_stat));	/* Счётчики выполнения */
+	prof_reset();
+	lat_reset();
+}
+
+/** 
+ * Вернуть модифицированное K(1:9) для выполнения операции "Сетунь-1958"
+ */
+trs_t control_trs( trs_t a ) {
+		int8_t k9;
+		trs_t k1_5;
+		trs_t r;
+		trs_t cn;
+
+		k1_5 = slice_trs(a,1,5);
+		/* Признак модификации адремной части K(9) */
+		k9 = trit2bit(a); 
+		
+		/* Модицикация адресной части K(1:5) */
+		if( k9 >= 1 ) { 	/* A(1:5) = A(1:5) + F(1:5) */ 			
+			vm_stat.mod_add++;
+			cn = add_trs(k1_5,F);
+			cn.tb <<= 4*2;
+			r.tb = a.tb & 0xFF; 		/* Очистить неиспользованные триты */
+			r.tb |= cn.tb & 0x3FF00 ;
+		}
+		else if( k9 <= -1 ) {	/* A(1:5) = A(1:5) - F(1:5) */
+			vm_stat.mod_sub++;
+			cn = sub_trs(k1_5,F);
+			cn.tb <<= 4*2;
+			r.tb = a.tb & 0xFF; 		/* Очистить неиспользованные триты */
+			r.tb |= cn.tb & 0x3FF00 ;
+		} 
+		else {					/* r = K(1:9) */
+			r = a;
+		}
+
+		r.l = 9;
+
+		return r;
+}
+
+/***************************************************************************************
+                   Таблица операций машина "Сетунь-1958"
+----------------------------------------------------------------------------------------
+Код(троичный)     Код        Название операции           W       Содержание команды 
++00        30         9        Посылка в S               w(S)    (A*)=>(S)
++0+        33        10        Сложение в S              w(S)    (S)+(A*)=>(S)
++0-        3х         8        Вычитание в S             w(S)    (S)-(A*)=>(S)
+++0        40        12        Умножение 0               w(S)    (S)=>(R); (A*)(R)=>(S)
++++        43        13        Умножение +               w(S)    (S)+(A*)(R)=>(S)
+++-        4х        11        Умножение -               w(S)    (A*)+(S)(R)=>(S)
++-0        20         6        Поразрядное умножение     w(S)    (A*)[x](S)=>(S)
++-+        23         7        Посылка в R               w(R)    (A*)=>(R)
++--        2х         5        Останов    Стоп;          w(R)    STOP; (A*)=>(C)
+0+0        10         3        Условный переход 0         -      A*=>(C) при w=0
+0++        13         4        Условный переход +         -      A*=>(C) при w=+
+0+-        1х         2        Условный переход -         -      A*=>(C) при w=-
+000        00         0        Безусловный переход        -      A*=>(C)
+00+        03         1        Запись из C                -      (C)=>(A*)
+00-        0х        -1        Запись из F               w(F)    (F)=>(A*)
+0-0        ц0        -3        Посылка в F               w(F)    (A*)=>(F)
+0--        цх        -4        Сложение в F              w(F)    (F)+(A*)=>(F)
+0-+        ц3        -2        Сложение в F c (C)        w(F)    (C)+(A*)=>(F)
+-+0        у0        -6        Сдвиг (S) на              w(S)    (A*)=>(S)
+-++        у3        -5        Запись из S               w(S)    (S)=>(A*)
+-+-        ух        -7        Нормализация              w(S)    Норм.(S)=>(A*); (N)=>(S)
+-00        х0        -9        Вывод-ввод    Ввод в Фа*.  -      Вывод из Фа*
+-0+        х3        -8        Запись на МБ               -      (Фа*)=>(Мд*)
+-0-        хх        -10        Считывание с МБ           -      (Мд*)=>(Фа*)
+--0        ж0        -12        Не задействована                 Аварийный стоп
+--+        ж3        -11        Не задействована                 Аварийный стоп
+---        жх        -13        Не задействована                 Аварийный стоп
+------------------------------------------------------------------------------------------
+*/
+/**
+ * Выполнить операцию K(1:9) машины "Сетунь-1958"
+ */
+int8_t execute_trs( trs_t addr, trs_t oper ) {
+//TODO для С(5) = -1 выполнить 2-раза страшей половине A(9:18) и сделать inc C
+
+		trs_t  k1_5; 		/* K(1:5)	*/
+		trs_t  k6_8; 		/* K(6:8)	*/
+		int8_t codeoper;	/* Код операции */
+
+		/* Адресная часть */	
+		k1_5 = slice_trs(addr,1,5);
+		k1_5.l = 5;
+
+		/* Код операции */	
+		k6_8 = oper;
+		k6_8.l = 3;
+
+		codeoper = get_trit_int(k6_8,1)*9 +
+		           get_trit_int(k6_8,2)*3 +
+				   get_trit_int(k6_8,3);		
+		vm_stat.op[codeoper + 13]++;
+		
+		/* ---------------------------------------
+		*  Выполнить операцию машины "Сетунь-1958"
+		*  ---------------------------------------
+		*/
+
+		/*
+		* Описание реализации команд машины «Сетунь»
+		*
+		* 5-разрядный регистр управления С, в котором содержится адрес
+		* выполняемой команды, после выполнения каждой команды в регистре С
+		* формируется адрес следующей команды причём за командой являющейся первой
+		* коротким кодом какой-либо ячейки, следует­ команда, являющаяся вторым 
+		* коротким кодом этой ячейки, а вслед за ней — ко­манда, являющаяся первым
+		* коротким кодом следующей ячейки, и т. д.;
+		* этот порядок может быть нарушен при выполнении команд
+		* перехода.
+		*
+		* При выполнении команд, использую­щих регистры F и С, операции производятся
+		* над 5-разрядными кодами, которые можно рассматривать как целые числа. 
+		* При выборке из памяти 5-разрядный код рассматривается как старшие пять разрядов 
+		* соответст­вующего короткого или длинного кода, при запоминании в ячейке 
+		* па­мяти 5-разрядный код записывается в старшие пять разрядов и допол­няется
+		* до соответствующего короткого или длинного кода записью нулей в остальные разряды.
+		* 
+		* При выполнении команд, использующих регистры S и R, выбираемые из памяти короткие коды
+		* рассматриваются как длин­ные с добавлением нулей в девять младших разрядов, а в оперативную
+        * память в качестве короткого кода записывается содержимое девяти старших разрядов регистра S 
+		* (запись в оперативную память непосред­ственно из регистра R невозможна).
+		*		
+		* После выполнения каждой команды вырабатывается значение неко­торого признака W = W(X) {-1,0,1}, 
+		* где X — обозначение какого-либо регистра, или сохраняется предыду­щее значение этого признака.		  
+        * 
+		* Команды условного перехода выполняются по-разному в зависимости от значения этого признака W.
+		* 
+		* При выполнении операций сложения, вычитания и умножения, использующих регистр S,
+		* может произойти останов машины по переполнению, если результат выполнения
 		* этой опе­рации, посылаемый в регистр S, окажется по модулю больше 4,5 .
 		* 
 		* Операция сдвига производит сдвиг содержимого регистра S на |N|-разрядов, где N рассматривается
@@ -2610,1142 +4859,4494 @@ int8_t execute_trs( trs_t addr, trs_t oper ) {
 		*
 		*/
 		
-		printf("A*=["); trit_to_symtrs(k1_5);
-		printf("]");
-		printf(", (% 4li), ",(long int)trs_to_digit(&k1_5));
+		if( trace_on ) {
+			char line[DIS_LINE];
+			fwrite(line, 1, dis_trace(line, k1_5) - line, stdout);
+		}
+		
+		switch( codeoper ) {
+			case (+1*9 +0*3 +0):  { // +00 : Посылка в S	(A*)=>(S)
+				TRACE("   k6..8[+00] : (A*)=>(S)\n");
+				MR = ld_fram(k1_5);
+				copy_trs(&MR,&S);
+				W = sgn_trs(S);
+				C = next_address(C);								
+			} break;
+			case (+1*9 +0*3 +1):  { // +0+ : Сложение в S	(S)+(A*)=>(S)
+				TRACE("   k6..8[+0+] : (S)+(A*)=>(S)\n");
+				MR = ld_fram(k1_5);				
+				S = add_trs(S,MR);
+				W = sgn_trs(S);
+				if( over(S) > 0 ) {					
+					goto error_over;
+				}
+				C = next_address(C);
+			} break;
+			case (+1*9 +0*3 -1):  { // +0- : Вычитание в S	(S)-(A*)=>(S)
+				TRACE("   k6..8[+0-] : (S)-(A*)=>(S)\n");
+				MR = ld_fram(k1_5);
+				
+				if( trace_on ) {
+					view_short_reg(&S,"S - =");
+					view_short_reg(&MR,"MR=");
+				}
+
+				S = sub_trs(S,MR);				
+				W = sgn_trs(S);
+				if( over(S) > 0 ) {					
+					goto error_over;
+				}
+				C = next_address(C);
+			} break;
+			case (+1*9 +1*3 +0):  { // ++0 : Умножение 0	(S)=>(R); (A*)(R)=>(S)
+				TRACE("   k6..8[++0] : (S)=>(R); (A*)(R)=>(S)\n");
+				copy_trs(&S,&R);				
+				MR = ld_fram(k1_5);				
+				//S = mul_trs(MR,R); //TODO
+				W = sgn_trs(S);
+				if( over(S) > 0 ) {
+					goto error_over;
+				} 
+				C = next_address(C);
+			} break;
+			case (+1*9 +1*3 +1):  { // +++ : Умножение +	(S)+(A*)(R)=>(S)
+				TRACE("   k6..8[+++] : (S)+(A*)(R)=>(S)\n");
+				MR = ld_fram(k1_5);				
+				//R = mul_trs(MR,R); //TODO реализовать
+				S = add_trs(S,R);
+				W = sgn_trs(S);
+				if( over(S) > 0 ) {
+					goto error_over;
+				} 
+				C = next_address(C);
+			} break;
+			case (+1*9 -1*3 +0):  { // +-0 : Поразрядное умножение	(A*)[x](S)=>(S)
+				TRACE("   k6..8[+-0] : (A*)[x](S)=>(S)\n");
+				trs_t m;
+				MR = ld_fram(k1_5);
+				/* (A*) по разрядам S, как при посылке в S */
+				m.l = S.l;
+				copy_trs(&MR,&m);
+				S = and_trs(m,S);
+				W = sgn_trs(S);
+				C = next_address(C);
+			} break;
+			case (+1*9 -1*3 +1):  { // +-+ : Посылка в R	(A*)=>(R)
+				TRACE("   k6..8[+-+] : (A*)=>(R)\n");
+				MR = ld_fram(k1_5);
+				copy_trs(&MR,&R);
+				W = sgn_trs(S);
+				C = next_address(C);
+			} break;
+			case (+1*9 -1*3 -1):  { // +-- : Останов	Стоп; (A*)=>(R)
+				TRACE("   k6..8[+--] : (A*)=>(R)\n");
+				MR = ld_fram(k1_5);
+				copy_trs(&MR,&R); 
+				C = next_address(C);
+				return STOP_DONE;
+			} break;
+			case (+0*9 +1*3 +0):  { // 0+0 : Условный переход -	A*=>(C) при w=0
+				TRACE("   k6..8[0+-] : A*=>(C) при w=0\n");
+				uint8_t w;
+				w = sgn(W);
+				if( w==0 ) {
+					if( prof_on ) {
+						prof_jump(C,k1_5);
+					}
+					copy_trs(&k1_5,&C); 
+					vm_stat.jump_taken++;
+				}
+				else {
+					C = next_address(C);
+					vm_stat.jump_not++;
+				} 
+			} break;
+			case (+0*9 +1*3 +1):  { // 0+1 : Условный переход -	A*=>(C) при w=0
+				TRACE("   k6..8[0+-] : A*=>(C) при w=+1\n");
+				uint8_t w;
+				w = sgn(W);
+				if( w==1 ) {
+					if( prof_on ) {
+						prof_jump(C,k1_5);
+					}
+					copy_trs(&k1_5,&C); 
+					vm_stat.jump_taken++;
+				}
+				else {
+					C = next_address(C);
+					vm_stat.jump_not++;
+				} 
+			} break;
+			case (+0*9 +1*3 -1):  { // 0+- : Условный переход -	A*=>(C) при w=-
+				TRACE("   k6..8[0+-] : A*=>(C) при w=-1\n");
+				uint8_t w;
+				w = sgn(W);
+				if( w<0 ) {
+					if( prof_on ) {
+						prof_jump(C,k1_5);
+					}
+					copy_trs(&k1_5,&C); 
+					vm_stat.jump_taken++;
+				}
+				else {
+					C = next_address(C);
+					vm_stat.jump_not++;
+				} 
+			} break;
+			case (+0*9 +0*3 +0): { //  000 : Безусловный переход	A*=>(C)
+				TRACE("   k6..8[000] : A*=>(C)\n");
+				if( prof_on ) {
+					prof_jump(C,k1_5);
+				}
+				copy_trs(&k1_5,&C); 
+			} break;
+			case (+0*9 +0*3 +1):  { // 00+ : Запись из C	(C)=>(A*)
+				TRACE("   k6..8[00+] : (C)=>(A*)\n");
+				st_fram(k1_5,C); 
+				C = next_address(C);
+			} break;
+			case (+0*9 +0*3 -1):  { // 00- : Запись из F	(F)=>(A*)
+				TRACE("   k6..8[00-] : (F)=>(A*)\n");
+				st_fram(k1_5,F);
+				W = sgn_trs(F); 
+				C = next_address(C);
+			} break;
+			case (+0*9 -1*3 +0):  { // 0-0 : Посылка в F	(A*)=>(F)
+				TRACE("   k6..8[0-0] : (A*)=>(F)\n");
+				MR = ld_fram(k1_5);
+				copy_trs(&MR,&F);
+				W = sgn_trs(F);
+				C = next_address(C);
+			} break;
+			case (+0*9 -1*3 +1):  { // 0-+ : Сложение в F c (C)	(C)+(A*)=>F
+				TRACE("   k6..8[0-+] : (C)+(A*)=>F\n");
+				MR = ld_fram(k1_5);
+				F = add_trs(C,MR);
+				W = sgn_trs(F);
+				C = next_address(C);
+			} break;
+			case (+0*9 -1*3 -1):  { // 0-- : Сложение в F	(F)+(A*)=>(F)
+				TRACE("   k6..8[0--] : (F)+(A*)=>(F)\n");
+				MR = ld_fram(k1_5);
+				F = add_trs(F,MR);
+				W = sgn_trs(F);
+				C = next_address(C);
+			} break;
+			case (-1*9 +1*3 +0):  { // -+0 : Сдвиг	Сдвиг (S) на (A*)=>(S)
+				TRACE("   k6..8[-+0] : (A*)=>(S)\n");
+				/*
+				* Операция сдвига производит сдвиг содержимого регистра S на \N\
+				* разрядов, где N рассматривается как 5-разрядный код, хранящийся в
+				* ячейке Л*, т. е. N = (А*). Сдвиг производится влево при N > 0 и вправо
+				* при N < 0. При N = 0 содержимое регистра 5 не изменяется.
+				*/
+				MR = ld_fram(k1_5);
+				//TODO add  S = shift_trs(S,trit2dec(MR));				
+				W = sgn_trs(S);
+				C = next_address(C);
+			} break;
+			case (-1*9 +1*3 +1):  { // -++ : Запись из S	(S)=>(A*)
+				TRACE("   k6..8[-++] : (S)=>(A*)\n");
+				if( (get_trit_int(k1_5,5) >= 0) && (S.l > 9) ) {
+					/* Короткое слово: старшие триты S, как при посылке в S */
+					MR = slice_trs(S,1,9);
+					st_fram(k1_5,MR);
+				}
+				else {
+					st_fram(k1_5,S);
+				}
+				W = sgn_trs(S);
+				C = next_address(C);
+			} break;
+			case (-1*9 +1*3 -1):  { // -+- : Нормализация	Норм.(S)=>(A*); (N)=>(S)
+				TRACE("   k6..8[-+-] : Норм.(S)=>(A*); (N)=>(S)\n");
+				/*
+				* Операция нормализации производит сдвиг (S) при (5) =£= 0 в таком
+				* направлении и на такое число разрядов |iV|, чтобы результат, посылаемый
+				* в ячейку ,4*, был но модулю больше V , но меньше / , т. е. чтобы в д в у х
+				* старших разрядах результата была записана комбинация троичных цифр
+				* 01 или 0 1 . При этом в регистр S посылается число N (5-разрядный код),
+				* знак которого определяется направлением сдвига, а именно: N > 0 при
+				* сдвиге вправо и N < 0 при сдвиге влево. П р и (S) = 0 или при
+				* / <|(*S)| < / в ячейку А* посылается (5), а в регистр S посылается N = 0.				
+				*/
+				//TODO описание операции
+				//
+				W = sgn_trs(S); 
+				C = next_address(C);				
+			} break;
+			case (-1*9 +0*3 +0):  { // -00 : Вывод-ввод	Ввод в Фа*, Вывод из Фа*
+				TRACE("   k6..8[-00] : I/O (Фа*)\n");
+				int8_t rc;
+				LAT_CALL(&lat_io, rc, io_xfer(k1_5));
+				if( rc != 0 ) {
+					return STOP_ERROR;
+				}
+				C = next_address(C);
+			} break;
+			case (-1*9 +0*3 +1):  { // -0+ : Запись на МБ	(Фа*)=>(Мд*)
+				TRACE("   k6..8[-0+] : (Фа*)=>(Мд*)\n");
+				int8_t rc;
+				LAT_CALL(&lat_drum, rc, drum_xfer(k1_5,1));
+				if( rc != 0 ) {
+					return STOP_ERROR;
+				}
+				C = next_address(C);
+			} break;
+			case (-1*9 +0*3 -1):  { // -0- : Считывание с МБ	(Мд*)=>(Фа*)
+				TRACE("   k6..8[-0-] : (Мд*)=>(Фа*)\n");
+				int8_t rc;
+				LAT_CALL(&lat_drum, rc, drum_xfer(k1_5,0));
+				if( rc != 0 ) {
+					return STOP_ERROR;
+				}
+				C = next_address(C);
+			} break;
+			case (-1*9 -1*3 +0):  { // --0 : Не задействована	Стоп
+				TRACE("   k6..8[--0] : STOP BREAK\n");
+				return STOP_ERROR;
+			} break;
+			case (-1*9 -1*3 +1):  { // --+ : Не задействована	Стоп
+				TRACE("   k6..8[--+] : STOP BREAK\n");
+				return STOP_ERROR;
+			} break;
+			case (-1*9 -1*3 -1):  { // --- : Не задействована	Стоп
+				TRACE("   k6..8[---] : STOP BREAK\n");
+				return STOP_ERROR;
+			} break;
+			default: {				// Не допустимая команда машины
+				TRACE("   k6..8 =[]   : STOP! NO OPERATION\n");
+				return STOP_ERROR; 
+			} 
+			break;
+		}	
+	return OK;				
+	
+	error_over:
+	vm_stat.over++;
+	return STOP_OVER;				
+
+}
+
+/**
+ * Контрольные точки длительных программ
+ */
+char *checkpoint_path = NULL;		/* файл контрольной точки */
+uint64_t checkpoint_every = 0;		/* период контрольных точек в операциях, 0 - нет */
+uint64_t checkpoint_next = 0;		/* номер операции следующей контрольной точки */
+volatile sig_atomic_t checkpoint_req = 0;	/* запрос по сигналу: 1 - записать, 2 - записать и остановить */
+
+/**
+ * Обработчик сигналов SIGUSR1 и SIGTERM для контрольной точки
+ */
+void checkpoint_signal(int sig) {
+	checkpoint_req = (sig == SIGTERM) ? 2 : 1;
+}
+
+/**
+ * Назначить файл и период контрольных точек
+ */
+void checkpoint_setup(char *path, uint64_t every) {
+
+	struct sigaction sa;
+
+	checkpoint_path  = path;
+	checkpoint_every = every;
+	checkpoint_next  = 0;
+	if( every > 0 ) {
+		checkpoint_next = (opers_count / every + 1) * every;
+	}
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = checkpoint_signal;
+	sa.sa_flags = SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGUSR1, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+}
+
+/**
+ * Останов программы: дождаться обменов устройств, записать вывод
+ *
+ * Пар:  ret_exec - статус последней операции
+ * Рез:  return - статус, STOP_ERROR при ошибке обмена
+ */
+uint8_t stop_setun_1958(uint8_t ret_exec) {
+
+	int8_t rc;
+
+	LAT_CALL(&lat_io, rc, io_drain());
+	if( rc != 0 ) {
+		ret_exec = STOP_ERROR;
+	}
+	out_flush_all();
+	return ret_exec;
+}
+
+/**
+ * Выполнить программу машины "Сетунь-1958" с адреса в регистре C
+ *
+ * Пар:  steps - максимальное количество операций
+ * Рез:  return - количество выполненных операций
+ *       ret - статус последней операции
+ */
+uint32_t run_setun_1958(uint32_t steps, uint8_t *ret) {
+
+	uint32_t i;
+	uint8_t ret_exec;
+	trs_t addr;
+	trs_t oper;
+	uint32_t lat_left;
+	uint64_t lat_t0;
+	uint64_t ckpt_at;
+
+	ret_exec = OK;
+	ckpt_at = UINT64_MAX;
+	lat_left = lat_every;
+	lat_t0 = 0;
+	for(i=0; i<steps; i++) {
+
+		if( lat_on && (--lat_left == 0) ) {
+			lat_left = lat_every;
+			lat_t0 = lat_now();
+		}
+		if( prof_on ) {
+			prof_step(C);
+		}
+		if( vcd_fd >= 0 ) {
+			vcd_window();
+		}
+		samp_phase = SAMP_FETCH;
+		K = ld_fram(C);
+		samp_phase = SAMP_DECODE;
+		addr = control_trs(K);
+		oper = slice_trs(K,6,8);
+
+		samp_phase = SAMP_EXEC;
+		ret_exec = execute_trs(addr,oper);
+		opers_count++;
+		cycles += TIME_OPER;
+		if( vcd_on ) {
+			vcd_step();
+		}
+
+		if( cycles >= event_next ) {
+			samp_phase = SAMP_DEVICE;
+			if( event_run() != 0 ) {
+				ret_exec = STOP_ERROR;
+			}
+		}
+		if( lat_t0 != 0 ) {
+			hist_add(&lat_step, lat_now() - lat_t0);
+			lat_t0 = 0;
+		}
+
+		if( (ret_exec == STOP_DONE) ||
+			(ret_exec == STOP_OVER) ||
+			(ret_exec == STOP_ERROR)
+		  ) {
+			i++;
+			ret_exec = stop_setun_1958(ret_exec);
+			break;
+		}
+
+		if( (checkpoint_path != NULL) &&
+			((opers_count == checkpoint_next) || (checkpoint_req != 0))
+		  ) {
+			if( opers_count == checkpoint_next ) {
+				checkpoint_next += checkpoint_every;
+			}
+			if( checkpoint_req == 2 ) {
+				/* Контрольная точка останова пишется после цикла */
+				checkpoint_req = 0;
+				i++;
+				break;
+			}
+			checkpoint_setun_1958(checkpoint_path);
+			ckpt_at = opers_count;
+			checkpoint_req = 0;
+		}
+	}
+
+	samp_phase = SAMP_HOST;
+
+	/* Состояние при останове сохраняется для продолжения,
+	   если оно не записано последней операцией цикла */
+	if( (checkpoint_path != NULL) && (ckpt_at != opers_count) ) {
+		checkpoint_setun_1958(checkpoint_path);
+	}
+
+	*ret = ret_exec;
+	return i;
+}
+
+/**
+ * Код операции K(6:8) по индексу счётчика тремя знаками '-', '0', '+'
+ */
+void stat_code(uint8_t i, char *s) {
+	s[0] = numb2symtrs((i / 9) - 1);
+	s[1] = numb2symtrs(((i / 3) % 3) - 1);
+	s[2] = numb2symtrs((i % 3) - 1);
+	s[3] = 0;
+}
+
+/**
+ * Печать счётчиков выполнения таблицей
+ */
+void stat_print(void) {
+
+	uint8_t i;
+	uint64_t n;
+	char code[4];
+
+	n = 0;
+	for(i=0; i<27; i++) {
+		n += vm_stat.op[i];
+	}
+
+	printf("\r\n[ Statistics Setun-1958: ]\r\n");
+	printf(" code  oper         count       %%\r\n");
+	for(i=0; i<27; i++) {
+		if( vm_stat.op[i] == 0 ) {
+			continue;
+		}
+		stat_code(i, code);
+		printf(" %s   %-6s %12llu  %6.2f\r\n", code,
+			   op_names[i] != NULL ? op_names[i] : "-",
+			   (unsigned long long)vm_stat.op[i], 100.0 * vm_stat.op[i] / n);
+	}
+	printf(" jumps taken     = %llu\r\n", (unsigned long long)vm_stat.jump_taken);
+	printf(" jumps not taken = %llu\r\n", (unsigned long long)vm_stat.jump_not);
+	printf(" K(9) A+F        = %llu\r\n", (unsigned long long)vm_stat.mod_add);
+	printf(" K(9) A-F        = %llu\r\n", (unsigned long long)vm_stat.mod_sub);
+	printf(" overflows       = %llu\r\n", (unsigned long long)vm_stat.over);
+	printf(" drum reads      = %llu\r\n", (unsigned long long)vm_stat.drum_rd);
+	printf(" drum writes     = %llu\r\n", (unsigned long long)vm_stat.drum_wr);
+	printf(" io transfers    = %llu\r\n", (unsigned long long)vm_stat.io);
+}
+
+/**
+ * Записать счётчики выполнения в файл JSON
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t stat_json(char *path) {
+
+	FILE *file;
+	uint8_t i;
+	char code[4];
+
+	file = fopen(path, "w");
+	if( file == NULL ) {
+		printf(" --- ERROR open '%s'\r\n", path);
+		return -1;
+	}
+	fprintf(file, "{\n  \"opers\": %llu,\n  \"time_us\": %llu,\n  \"ops\": {",
+			(unsigned long long)opers_count, (unsigned long long)cycles);
+	for(i=0; i<27; i++) {
+		stat_code(i, code);
+		fprintf(file, "%s\n    \"%s\": {\"name\": \"%s\", \"count\": %llu}", (i == 0) ? "" : ",",
+				code, op_names[i] != NULL ? op_names[i] : "", (unsigned long long)vm_stat.op[i]);
+	}
+	fprintf(file, "\n  },\n"
+			"  \"jumps\": {\"taken\": %llu, \"not_taken\": %llu},\n"
+			"  \"modify\": {\"add\": %llu, \"sub\": %llu},\n"
+			"  \"over\": %llu,\n"
+			"  \"drum\": {\"read\": %llu, \"write\": %llu},\n"
+			"  \"io\": %llu\n}\n",
+			(unsigned long long)vm_stat.jump_taken, (unsigned long long)vm_stat.jump_not,
+			(unsigned long long)vm_stat.mod_add, (unsigned long long)vm_stat.mod_sub,
+			(unsigned long long)vm_stat.over,
+			(unsigned long long)vm_stat.drum_rd, (unsigned long long)vm_stat.drum_wr,
+			(unsigned long long)vm_stat.io);
+	if( fclose(file) != 0 ) {
+		printf(" --- ERROR write '%s'\r\n", path);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Кадр стека: адрес C(1:5) тритами и мнемоника операции слова
+ */
+char * prof_frame(char *p, uint16_t a) {
+
+	trs_t ea;
+	trishort w;
+	const char *name;
+
+	ea.l = 5;
+	ea.tb = a;
+	w = ld_fram(ea).tb;
+	name = op_names[tb2int(w >> 6) * 9 + tb2int(w >> 4) * 3 + tb2int(w >> 2) + 13];
+	p = dis_trits(p, a, 5);
+	*p++ = ':';
+	return dis_str(p, name != NULL ? name : "word");
+}
+
+/**
+ * Записать свёрнутые стеки "участок;адрес:операция число" для flamegraph.pl
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t prof_folded(char *path) {
+
+	FILE *file;
+	uint16_t i;
+	char line[DIS_LINE];
+	char *p;
+
+	file = fopen(path, "w");
+	if( file == NULL ) {
+		printf(" --- ERROR open '%s'\r\n", path);
+		return -1;
+	}
+	for(i=0; i<PROF_PAIRS; i++) {
+		if( prof_blocks[i].key == 0 ) {
+			continue;
+		}
+		p = prof_frame(line, (prof_blocks[i].key >> 10) & (PROF_SLOTS - 1));
+		*p++ = ';';
+		p = prof_frame(p, prof_blocks[i].key & (PROF_SLOTS - 1));
+		*p++ = ' ';
+		p = dis_int(p, prof_blocks[i].n, 0, 0);
+		*p++ = '\n';
+		fwrite(line, 1, p - line, file);
+	}
+	if( fclose(file) != 0 ) {
+		printf(" --- ERROR write '%s'\r\n", path);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Записать дизассемблер FRAM со счётчиками выполнения по адресам
+ * и выполненными переходами с каждого адреса
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t prof_dis(char *path) {
+
+	FILE *file;
+	uint16_t i;
+	uint16_t j;
+	uint16_t a;
+	trs_t ea;
+	trishort w;
+	char line[DIS_LINE];
+	char *p;
+
+	file = fopen(path, "w");
+	if( file == NULL ) {
+		printf(" --- ERROR open '%s'\r\n", path);
+		return -1;
+	}
+	ea = smtr("----0");
+	for(i=0; i<SIZE_ALL_TRIT_FRAM; i++) {
+		a = ea.tb & (PROF_SLOTS - 1);
+		w = ld_fram(ea).tb;
+		if( (prof_hits[a] != 0) || (w != 0) ) {
+			p = dis_int(line, prof_hits[a], 12, 0);
+			*p++ = ' ';
+			*p++ = ' ';
+			p = dis_trits(p, a, 5);
+			*p++ = ' ';
+			*p++ = ' ';
+			p = dis_nonary(p, w);
+			*p++ = ' ';
+			*p++ = ' ';
+			p = dis_oper(p, w);
+			*p++ = '\n';
+			fwrite(line, 1, p - line, file);
+		}
+		for(j=0; j<PROF_PAIRS; j++) {
+			if( (prof_jumps[j].key != 0) && (((prof_jumps[j].key >> 10) & (PROF_SLOTS - 1)) == a) ) {
+				p = dis_str(line, "                    -> ");
+				p = dis_trits(p, prof_jumps[j].key & (PROF_SLOTS - 1), 5);
+				*p++ = ' ';
+				p = dis_int(p, prof_jumps[j].n, 0, 0);
+				*p++ = '\n';
+				fwrite(line, 1, p - line, file);
+			}
+		}
+		ea = next_address(ea);
+	}
+	if( prof_lost != 0 ) {
+		fprintf(file, "lost pairs: %llu\n", (unsigned long long)prof_lost);
+	}
+	if( fclose(file) != 0 ) {
+		printf(" --- ERROR write '%s'\r\n", path);
+		return -1;
+	}
+	return 0;
+}
+
+static uint32_t samp_hits[PROF_SLOTS];	/* выборки по адресу для отчёта */
+
+/**
+ * Сравнение адресов по числу выборок для qsort()
+ */
+int samp_cmp(const void *a, const void *b) {
+	uint32_t x = samp_hits[*(const uint16_t *)a];
+	uint32_t y = samp_hits[*(const uint16_t *)b];
+	return (x < y) - (x > y);
+}
+
+/**
+ * Записать отчёт выборок: фазы цикла, коды операций,
+ * адреса по убыванию числа выборок с долями фаз
+ */
+void samp_report(void) {
+
+	static const char *phases[SAMP_PHASES] = { "host", "fetch", "decode", "exec", "device" };
+	static uint32_t addr_phase[PROF_SLOTS][SAMP_PHASES];
+	static uint16_t order[PROF_SLOTS];
+	uint32_t phase[SAMP_PHASES];
+	uint32_t ops[27];
+	uint32_t n;
+	uint32_t lost;
+	uint32_t i;
+	uint16_t a;
+	uint8_t j;
+	trs_t ea;
+	trishort w;
+	FILE *file;
+	char line[DIS_LINE];
+	char *p;
+
+	samp_timer(0);
+	n = atomic_load(&samp_count);
+	lost = (n > SAMP_MAX) ? n - SAMP_MAX : 0;
+	n -= lost;
+
+	memset(phase, 0, sizeof(phase));
+	memset(ops, 0, sizeof(ops));
+	memset(samp_hits, 0, sizeof(samp_hits));
+	memset(addr_phase, 0, sizeof(addr_phase));
+	for(i=0; i<n; i++) {
+		phase[samp_buf[i].phase % SAMP_PHASES]++;
+		if( samp_buf[i].phase != SAMP_HOST ) {
+			ops[samp_buf[i].op % 27]++;
+			samp_hits[samp_buf[i].c]++;
+			addr_phase[samp_buf[i].c][samp_buf[i].phase % SAMP_PHASES]++;
+		}
+	}
+
+	file = fopen(samp_path, "w");
+	if( file == NULL ) {
+		printf(" --- ERROR open '%s'\r\n", samp_path);
+		return;
+	}
+	fprintf(file, "samples %u lost %u hz %u\n\nphase\n", n, lost, samp_hz);
+	for(j=0; j<SAMP_PHASES; j++) {
+		fprintf(file, "  %-8s %10u %6.2f%%\n", phases[j], phase[j], n ? 100.0 * phase[j] / n : 0.0);
+	}
+
+	fprintf(file, "\noper\n");
+	for(j=0; j<27; j++) {
+		if( ops[j] != 0 ) {
+			fprintf(file, "  %-8s %10u %6.2f%%\n", op_names[j] != NULL ? op_names[j] : "word",
+					ops[j], 100.0 * ops[j] / n);
+		}
+	}
+
+	fprintf(file, "\n     samples   fetch  decode    exec  device  addr   word   oper\n");
+	for(i=0; i<PROF_SLOTS; i++) {
+		order[i] = (uint16_t)i;
+	}
+	qsort(order, PROF_SLOTS, sizeof(order[0]), samp_cmp);
+	for(i=0; i<PROF_SLOTS && samp_hits[order[i]] != 0; i++) {
+		a = order[i];
+		ea.l = 5;
+		ea.tb = a;
+		w = ld_fram(ea).tb;
+		p = dis_int(line, samp_hits[a], 12, 0);
+		for(j=SAMP_FETCH; j<SAMP_PHASES; j++) {
+			p = dis_int(p, addr_phase[a][j], 8, 0);
+		}
+		*p++ = ' ';
+		*p++ = ' ';
+		p = dis_trits(p, a, 5);
+		*p++ = ' ';
+		*p++ = ' ';
+		p = dis_nonary(p, w);
+		*p++ = ' ';
+		*p++ = ' ';
+		p = dis_oper(p, w);
+		*p++ = '\n';
+		fwrite(line, 1, p - line, file);
+	}
+	if( fclose(file) != 0 ) {
+		printf(" --- ERROR write '%s'\r\n", samp_path);
+	}
+}
+
+/**
+ * Включить выборочный профиль, отчёт в файл path при завершении
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t samp_start(char *path, uint32_t hz) {
+
+	struct sigaction sa;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = samp_signal;
+	sa.sa_flags = SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	if( sigaction(SIGPROF, &sa, NULL) != 0 ) {
+		printf(" --- ERROR sigaction SIGPROF\r\n");
+		return -1;
+	}
+	samp_path = path;
+	samp_hz = (hz > 0) ? hz : SAMP_HZ;
+	atomic_init(&samp_count, 0);
+	atexit(samp_report);
+	samp_timer(samp_hz);
+	return 0;
+}
+
+/** *********************************************
+ *  Загрузка программ из файлов '*.txs'
+ *  ---------------------------------------------
+ */
+
+/**
+ * Номер зоны барабана в девятеричном виде, например "1w", в троичный код
+ */
+void zone_str_2_trs( uint8_t * syms, trs_t * r )  {
+
+	uint8_t i;
+	uint8_t symtrs_str[8];
+
+	r->l  = 4;
+	r->tb = 0;
+	if( strlen(syms) != 2) {
+		return;
+	}
+	sprintf(symtrs_str,"%2s%2s",
+			lt2symtrs(syms[0]),
+			lt2symtrs(syms[1])
+		);
+	for(i=0;i<4;i++) {
+		set_trit(r,i+1,symtrs2numb(symtrs_str[i]));
+	}
+}
+
+/**
+ * Загрузить программу из файла '*.txs' в ферритовую память
+ * с адреса '----0' по коротким словам.
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t load_txs_fram(char *path) {
+
+	FILE *file;
+	uint8_t cmd[20];
+	uint16_t n;
+	trs_t inr;
+	trs_t dst;
+
+	file = fopen(path, "r");
+	if( file == NULL ) {
+		printf(" --- ERROR open '%s'\r\n", path);
+		return -1;
+	}
+
+	inr = smtr("----0"); /* cчетчик адреса коротких слов */
+	dst.l = 9;
+	n = 0;
+	while( (n < SIZE_ALL_TRIT_FRAM) && (fscanf(file, "%19s", cmd) == 1) ) {
+		dst.tb = 0;
+		cmd_str_2_trs(cmd,&dst);
+		st_fram(inr,dst);
+		inr = next_address(inr);
+		n++;
+	}
+	fclose(file);
+
+	return 0;
+}
+
+/**
+ * Загрузить зону магнитного барабана из файла '*.txs'
+ *
+ * Пар:  zone - номер зоны MB(1:4)
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t load_txs_drum(char *path, trs_t zone) {
+
+	FILE *file;
+	uint8_t cmd[20];
+	uint8_t row;
+	int8_t zind;
+	trs_t dst;
+
+	zind = mb_to_zone_index(zone);
+	if( zind < 0 ) {
+		printf(" --- ERROR zone drum\r\n");
+		return -1;
+	}
+
+	file = fopen(path, "r");
+	if( file == NULL ) {
+		printf(" --- ERROR open '%s'\r\n", path);
+		return -1;
+	}
+
+	dst.l = 9;
+	row = 0;
+	while( (row < SIZE_ZONE_TRIT_DRUM) && (fscanf(file, "%19s", cmd) == 1) ) {
+		dst.tb = 0;
+		cmd_str_2_trs(cmd,&dst);
+		drum_zone_wr(zind)[row] = (trishort)(dst.tb & 0x3FFFF);
+		row++;
+	}
+	fclose(file);
+	DRUM_TOUCH(zind);
+
+	return 0;
+}
+
+/** *********************************************
+ *  Ассемблер машины "Сетунь-1958"
+ *  ---------------------------------------------
+ *
+ *  Строка программы:  [метка:] [операция [A*] [, +F | , -F]] [; комментарий]
+ *
+ *  Операции по таблице мнемоник op_names (см. execute_trs):
+ *  LDS ADD SUB MUL0 MULP MULM AND LDR STOP JZ JP JN JMP STC STF LDF
+ *  ADDF ADCF SHIFT STS NORM IO DWR DRD. Признак K(9): ",+F" - A+F, ",-F" - A-F.
+ *
+ *  Выражение: слагаемые через '+' и '-'. Слагаемое: десятичное число,
+ *  троичное '%+0-', девятеричное слово '#0002X', метка, '.' - адрес слова.
+ *
+ *  Директивы:
+ *  .org A          - следующее слово FRAM по адресу A (A(5) = 0 или +)
+ *  .zone 1w [, f]  - слова в зону барабана 1w, метки по адресам зоны FRAM f (-, 0, +)
+ *  .fram           - продолжить слова FRAM
+ *  .word e, ...    - короткие слова
+ *  .long e, ...    - длинные слова с начала строки, адрес A(5) = - равен метке - 1
+ *  .zero n         - n нулевых коротких слов
+ *  .equ имя, e     - значение имени
+ *
+ *  Слова FRAM идут в порядке загрузки '*.txs' с адреса '----0'.
+ *  Метки разрешаются за один проход: ссылка вперёд запоминается
+ *  и исправляется по определению метки в конце текста.
+ */
+#define ASM_LINE		(256)	/* длина строки текста */
+#define ASM_NAME		(32)	/* длина имени */
+#define ASM_SYMS		(1024)	/* мест в таблице имён, степень 2 */
+#define ASM_FIXUPS		(4096)	/* мест для ссылок вперёд */
+#define ASM_FRAM		(-1)	/* размещение слов в FRAM */
+
+typedef struct asm_sym {
+	char name[ASM_NAME];
+	int32_t v;			/* значение */
+	uint8_t def;		/* 1 - определено */
+} asm_sym_t;
+
+typedef struct asm_fix {
+	int8_t zone;		/* ASM_FRAM или индекс зоны барабана */
+	uint8_t pos;		/* индекс слова */
+	uint8_t addr;		/* 1 - поле A(1:5), 0 - слово */
+	uint16_t sym;		/* индекс имени */
+	int32_t off;		/* слагаемое к значению имени */
+	uint32_t line;		/* строка текста */
+} asm_fix_t;
+
+static asm_sym_t asm_syms[ASM_SYMS];
+static asm_fix_t asm_fix[ASM_FIXUPS];
+static uint16_t asm_nfix;
+
+static int16_t asm_addr[SIZE_ALL_TRIT_FRAM];	/* адрес слова по порядку загрузки */
+static int16_t asm_index[2 * TRIT5_MAX + 1];	/* порядок загрузки по адресу, -1 - нет */
+
+static trishort asm_fram[SIZE_ALL_TRIT_FRAM];	/* слова FRAM */
+static uint8_t asm_fram_n;						/* слов FRAM до последнего занятого */
+static trishort asm_drum[NUMBER_ZONE_DRUM][SIZE_ZONE_TRIT_DRUM];	/* зоны барабана */
+static uint8_t asm_drum_n[NUMBER_ZONE_DRUM];	/* слов в зоне, 0 - зона не занята */
+static char asm_drum_name[NUMBER_ZONE_DRUM][3];	/* номер зоны как в тексте */
+
+static int8_t asm_zone;		/* ASM_FRAM или индекс зоны барабана */
+static uint8_t asm_pc;		/* следующее слово FRAM */
+static uint8_t asm_row;		/* следующее слово зоны барабана */
+static uint8_t asm_fz;		/* зона FRAM меток зоны барабана */
+static char *asm_path;
+static uint32_t asm_line;
+
+/**
+ * Ошибка строки текста
+ *
+ * Рез:  return=-1
+ */
+int8_t asm_error(char *msg) {
+	printf(" --- ERROR asm %s:%u: %s\r\n", asm_path, asm_line, msg);
+	return -1;
+}
+
+/**
+ * Число в поле битов n тритов
+ */
+trishort asm_int2tb(int32_t v, uint8_t n) {
+
+	uint8_t i;
+	int8_t t;
+	trishort r;
+
+	r = 0;
+	for(i=0; i<n; i++) {
+		t = ((v % 3) + 3) % 3;
+		if( t == 2 ) {
+			t = -1;
+		}
+		v = (v - t) / 3;
+		r |= (trishort)bit2tb(t) << (2*i);
+	}
+	return r;
+}
+
+/**
+ * Место имени в таблице имён: хэш FNV-1a и линейный поиск
+ *
+ * Рез:  return>=0 - индекс, return<0 - таблица полна
+ */
+int16_t asm_sym(char *name) {
+
+	uint32_t h;
+	uint16_t i;
+	uint16_t n;
+	char *c;
+
+	h = 2166136261u;
+	for(c = name; *c; c++) {
+		h ^= (uint8_t)*c;
+		h *= 16777619u;
+	}
+	for(n=0; n<ASM_SYMS; n++) {
+		i = (h + n) & (ASM_SYMS - 1);
+		if( asm_syms[i].name[0] == 0 ) {
+			strcpy(asm_syms[i].name, name);
+			return i;
+		}
+		if( strcmp(asm_syms[i].name, name) == 0 ) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/**
+ * Пропустить пробелы
+ */
+char * asm_skip(char *p) {
+	while( (*p == ' ') || (*p == '\t') ) {
+		p++;
+	}
+	return p;
+}
+
+/**
+ * Прочитать имя [A-Za-z_.][A-Za-z0-9_.]*
+ *
+ * Рез:  return=0 - OK', return|=0 - нет имени
+ */
+int8_t asm_ident(char **pp, char *name) {
+
+	char *p;
+	uint8_t n;
+
+	p = *pp;
+	if( !((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z') || *p == '_' || *p == '.') ) {
+		return -1;
+	}
+	n = 0;
+	while( (*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z') || (*p >= '0' && *p <= '9') ||
+		   *p == '_' || *p == '.' ) {
+		if( n < ASM_NAME - 1 ) {
+			name[n++] = *p;
+		}
+		p++;
+	}
+	name[n] = 0;
+	*pp = p;
+	return 0;
+}
+
+/**
+ * Адрес следующего слова
+ */
+int32_t asm_here(void) {
+	if( asm_zone == ASM_FRAM ) {
+		return asm_addr[asm_pc < SIZE_ALL_TRIT_FRAM ? asm_pc : SIZE_ALL_TRIT_FRAM - 1];
+	}
+	return asm_addr[asm_fz * SIZE_ZONE_TRIT_DRUM + (asm_row < SIZE_ZONE_TRIT_DRUM ? asm_row : 0)];
+}
+
+/**
+ * Вычислить выражение.
+ * Не более одного неопределённого имени со знаком '+': его индекс в *sym.
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t asm_expr(char **pp, int32_t *v, int16_t *sym) {
+
+	char *p;
+	char name[ASM_NAME];
+	int8_t sign;
+	int32_t t;
+	int16_t i;
+	trishort w;
+
+	p = asm_skip(*pp);
+	*v = 0;
+	*sym = -1;
+	sign = 1;
+	if( *p == '-' || *p == '+' ) {
+		sign = (*p == '-') ? -1 : 1;
+		p = asm_skip(p + 1);
+	}
+	for(;;) {
+		if( *p >= '0' && *p <= '9' ) {
+			t = strtol(p, &p, 10);
+		}
+		else if( *p == '%' ) {
+			p++;
+			t = 0;
+			while( *p == '-' || *p == '0' || *p == '+' ) {
+				t = t * 3 + symtrs2numb(*p++);
+			}
+		}
+		else if( *p == '#' ) {
+			if( nonary_word((uint8_t *)p + 1, &w) != 0 ) {
+				return asm_error("bad nonary word");
+			}
+			p += 6;
+			t = tb_to_digit(w);
+		}
+		else if( *p == '.' && !((p[1] >= 'A' && p[1] <= 'Z') || (p[1] >= 'a' && p[1] <= 'z')) ) {
+			p++;
+			t = asm_here();
+		}
+		else if( asm_ident(&p, name) == 0 ) {
+			i = asm_sym(name);
+			if( i < 0 ) {
+				return asm_error("symbol table full");
+			}
+			if( asm_syms[i].def ) {
+				t = asm_syms[i].v;
+			}
+			else if( (*sym < 0) && (sign > 0) ) {
+				*sym = i;
+				t = 0;
+			}
+			else {
+				return asm_error("forward reference in expression");
+			}
+		}
+		else {
+			return asm_error("bad expression");
+		}
+		*v += sign * t;
+		p = asm_skip(p);
+		if( *p == '+' || *p == '-' ) {
+			sign = (*p == '-') ? -1 : 1;
+			p = asm_skip(p + 1);
+			continue;
+		}
+		break;
+	}
+	*pp = p;
+	return 0;
+}
+
+/**
+ * Слово по месту размещения
+ */
+trishort * asm_word(int8_t zone, uint8_t pos) {
+	if( zone == ASM_FRAM ) {
+		return &asm_fram[pos];
+	}
+	return &asm_drum[zone][pos];
+}
+
+/**
+ * Записать поле слова: A(1:5) или всё слово
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t asm_patch(trishort *w, uint8_t addr, int32_t v) {
+	if( addr ) {
+		if( v < TRIT5_MIN || v > TRIT5_MAX ) {
+			return asm_error("address out of range");
+		}
+		*w = (*w & 0xFF) | (asm_int2tb(v, 5) << 8);
+	}
+	else {
+		if( v < TRIT9_MIN || v > TRIT9_MAX ) {
+			return asm_error("word out of range");
+		}
+		*w = asm_int2tb(v, 9);
+	}
+	return 0;
+}
+
+/**
+ * Занять следующее слово
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t asm_emit(trishort w, uint8_t addr, int32_t v, int16_t sym) {
+
+	int8_t zone;
+	uint8_t pos;
+
+	zone = asm_zone;
+	if( zone == ASM_FRAM ) {
+		if( asm_pc >= SIZE_ALL_TRIT_FRAM ) {
+			return asm_error("FRAM is full");
+		}
+		pos = asm_pc++;
+		if( asm_fram_n < asm_pc ) {
+			asm_fram_n = asm_pc;
+		}
+	}
+	else {
+		if( asm_row >= SIZE_ZONE_TRIT_DRUM ) {
+			return asm_error("drum zone is full");
+		}
+		pos = asm_row++;
+		if( asm_drum_n[zone] < asm_row ) {
+			asm_drum_n[zone] = asm_row;
+		}
+	}
+	*asm_word(zone, pos) = w;
+
+	if( sym >= 0 ) {
+		if( asm_nfix >= ASM_FIXUPS ) {
+			return asm_error("too many forward references");
+		}
+		asm_fix[asm_nfix].zone = zone;
+		asm_fix[asm_nfix].pos  = pos;
+		asm_fix[asm_nfix].addr = addr;
+		asm_fix[asm_nfix].sym  = sym;
+		asm_fix[asm_nfix].off  = v;
+		asm_fix[asm_nfix].line = asm_line;
+		asm_nfix++;
+		return 0;
+	}
+	return asm_patch(asm_word(zone, pos), addr, v);
+}
+
+/**
+ * Операция машины: A* и признак K(9)
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t asm_oper(int8_t code, char *p) {
+
+	int32_t v;
+	int16_t sym;
+	int8_t k9;
+
+	v = 0;
+	sym = -1;
+	k9 = 0;
+	p = asm_skip(p);
+	if( *p != 0 && *p != ',' ) {
+		if( asm_expr(&p, &v, &sym) != 0 ) {
+			return -1;
+		}
+	}
+	if( *p == ',' ) {
+		p = asm_skip(p + 1);
+		k9 = 1;
+		if( *p == '+' || *p == '-' ) {
+			k9 = (*p == '-') ? -1 : 1;
+			p = asm_skip(p + 1);
+		}
+		if( *p != 'F' && *p != 'f' ) {
+			return asm_error("expected F");
+		}
+		p = asm_skip(p + 1);
+	}
+	if( *p != 0 ) {
+		return asm_error("extra text");
+	}
+	return asm_emit((asm_int2tb(code, 3) << 2) | asm_int2tb(k9, 1), 1, v, sym);
+}
+
+/**
+ * Директива
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t asm_directive(char *name, char *p) {
+
+	int32_t v;
+	int16_t sym;
+	int16_t i;
+	char zn[ASM_NAME];
+	trs_t zone;
+	int8_t z;
+
+	p = asm_skip(p);
+	if( strcmp(name, ".word") == 0 || strcmp(name, ".long") == 0 ) {
+		if( name[1] == 'l' && (asm_here() % 3 != 0) && asm_emit(0, 0, 0, -1) != 0 ) {
+			return -1;	/* длинное слово с начала строки */
+		}
+		for(;;) {
+			if( asm_expr(&p, &v, &sym) != 0 ) {
+				return -1;
+			}
+			if( name[1] == 'l' ) {
+				if( sym >= 0 ) {
+					return asm_error("forward reference in .long");
+				}
+				if( v < TRIT18_MIN || v > TRIT18_MAX ) {
+					return asm_error("long word out of range");
+				}
+				/* старшие и младшие 9 тритов: v = hi * 3^9 + lo */
+				i = ((v % 19683) + 19683) % 19683;
+				if( i > TRIT9_MAX ) {
+					i -= 19683;
+				}
+				if( asm_emit(0, 0, (v - i) / 19683, -1) != 0 || asm_emit(0, 0, i, -1) != 0 ) {
+					return -1;
+				}
+			}
+			else if( asm_emit(0, 0, v, sym) != 0 ) {
+				return -1;
+			}
+			if( *p != ',' ) {
+				break;
+			}
+			p++;
+		}
+	}
+	else if( strcmp(name, ".zero") == 0 ) {
+		if( asm_expr(&p, &v, &sym) != 0 ) {
+			return -1;
+		}
+		if( sym >= 0 || v < 0 ) {
+			return asm_error("bad count");
+		}
+		while( v-- > 0 ) {
+			if( asm_emit(0, 0, 0, -1) != 0 ) {
+				return -1;
+			}
+		}
+	}
+	else if( strcmp(name, ".equ") == 0 ) {
+		if( asm_ident(&p, zn) != 0 ) {
+			return asm_error("expected name");
+		}
+		p = asm_skip(p);
+		if( *p++ != ',' ) {
+			return asm_error("expected ','");
+		}
+		if( asm_expr(&p, &v, &sym) != 0 ) {
+			return -1;
+		}
+		if( sym >= 0 ) {
+			return asm_error("forward reference in .equ");
+		}
+		i = asm_sym(zn);
+		if( i < 0 ) {
+			return asm_error("symbol table full");
+		}
+		if( asm_syms[i].def ) {
+			return asm_error("symbol redefined");
+		}
+		asm_syms[i].v = v;
+		asm_syms[i].def = 1;
+	}
+	else if( strcmp(name, ".org") == 0 ) {
+		if( asm_expr(&p, &v, &sym) != 0 ) {
+			return -1;
+		}
+		if( sym >= 0 || v < TRIT5_MIN || v > TRIT5_MAX || asm_index[v + TRIT5_MAX] < 0 ) {
+			return asm_error("bad .org address");
+		}
+		asm_zone = ASM_FRAM;
+		asm_pc = asm_index[v + TRIT5_MAX];
+	}
+	else if( strcmp(name, ".fram") == 0 ) {
+		asm_zone = ASM_FRAM;
+	}
+	else if( strcmp(name, ".zone") == 0 ) {
+		zn[0] = p[0];
+		zn[1] = (p[0] != 0) ? p[1] : 0;
+		zn[2] = 0;
+		zone_str_2_trs((uint8_t *)zn, &zone);
+		z = mb_to_zone_index(zone);
+		if( strlen(zn) != 2 || nonary_bits[(uint8_t)zn[0]] == 0 ||
+			nonary_bits[(uint8_t)zn[1]] == 0 || z < 0 ) {
+			return asm_error("bad drum zone");
+		}
+		p = asm_skip(p + 2);
+		asm_fz = 1;
+		if( *p == ',' ) {
+			p = asm_skip(p + 1);
+			if( *p != '-' && *p != '0' && *p != '+' ) {
+				return asm_error("bad FRAM zone");
+			}
+			asm_fz = symtrs2numb(*p) + 1;
+		}
+		asm_zone = z;
+		asm_row = asm_drum_n[z];
+		strcpy(asm_drum_name[z], zn);
+	}
+	else {
+		return asm_error("unknown directive");
+	}
+	return 0;
+}
+
+/**
+ * Строка текста
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t asm_stmt(char *p) {
+
+	char name[ASM_NAME];
+	char *c;
+	char *q;
+	int16_t i;
+	uint8_t k;
+
+	c = strchr(p, ';');
+	if( c != NULL ) {
+		*c = 0;
+	}
+	c = p + strlen(p);
+	while( c > p && (c[-1] == ' ' || c[-1] == '\t' || c[-1] == '\r' || c[-1] == '\n') ) {
+		*--c = 0;
+	}
+
+	p = asm_skip(p);
+	q = p;
+	if( asm_ident(&q, name) == 0 && *q == ':' ) {
+		i = asm_sym(name);
+		if( i < 0 ) {
+			return asm_error("symbol table full");
+		}
+		if( asm_syms[i].def ) {
+			return asm_error("label redefined");
+		}
+		asm_syms[i].v = asm_here();
+		asm_syms[i].def = 1;
+		p = asm_skip(q + 1);
+	}
+	if( *p == 0 ) {
+		return 0;
+	}
+	if( asm_ident(&p, name) != 0 ) {
+		return asm_error("expected operation");
+	}
+	if( name[0] == '.' ) {
+		return asm_directive(name, p);
+	}
+	for(c = name; *c; c++) {
+		if( *c >= 'a' && *c <= 'z' ) {
+			*c -= 'a' - 'A';
+		}
+	}
+	for(k=0; k < 27; k++) {
+		if( (op_names[k] != NULL) && (strcmp(op_names[k], name) == 0) ) {
+			return asm_oper(k - 13, p);
+		}
+	}
+	return asm_error("unknown operation");
+}
+
+/**
+ * Ассемблировать текст программы из file и загрузить слова в память машины,
+ * path - имя текста в сообщениях
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t asm_file(FILE *file, char *path) {
+
+	char buf[ASM_LINE];
+	uint16_t i;
+	uint8_t z;
+	asm_fix_t *f;
+	trs_t a;
+	trs_t v;
+
+	memset(asm_syms, 0, sizeof(asm_syms));
+	memset(asm_fram, 0, sizeof(asm_fram));
+	memset(asm_drum, 0, sizeof(asm_drum));
+	memset(asm_drum_n, 0, sizeof(asm_drum_n));
+	memset(asm_index, 0xFF, sizeof(asm_index));
+	a = smtr("----0");
+	for(i=0; i<SIZE_ALL_TRIT_FRAM; i++) {
+		asm_addr[i] = trs_to_digit(&a);
+		asm_index[asm_addr[i] + TRIT5_MAX] = i;
+		a = next_address(a);
+	}
+	asm_nfix = 0;
+	asm_fram_n = 0;
+	asm_zone = ASM_FRAM;
+	asm_pc = 0;
+	asm_path = path;
+	asm_line = 0;
+
+	while( fgets(buf, sizeof(buf), file) != NULL ) {
+		asm_line++;
+		if( asm_stmt(buf) != 0 ) {
+			return -1;
+		}
+	}
+
+	/* Ссылки вперёд */
+	for(i=0; i<asm_nfix; i++) {
+		f = &asm_fix[i];
+		asm_line = f->line;
+		if( !asm_syms[f->sym].def ) {
+			printf(" --- ERROR asm %s:%u: undefined '%s'\r\n", path, f->line, asm_syms[f->sym].name);
+			return -1;
+		}
+		if( asm_patch(asm_word(f->zone, f->pos), f->addr, asm_syms[f->sym].v + f->off) != 0 ) {
+			return -1;
+		}
+	}
+
+	/* Загрузить слова в FRAM и зоны барабана */
+	v.l = 9;
+	for(i=0; i<asm_fram_n; i++) {
+		a.l = 5;
+		a.tb = asm_int2tb(asm_addr[i], 5);
+		v.tb = asm_fram[i];
+		st_fram(a, v);
+	}
+	for(z=0; z<NUMBER_ZONE_DRUM; z++) {
+		if( asm_drum_n[z] != 0 ) {
+			memcpy(drum_zone_wr(z), asm_drum[z], SIZE_ZONE_BYTES);
+			DRUM_TOUCH(z);
+		}
+	}
+	return 0;
+}
+
+/**
+ * Ассемблировать программу из файла и загрузить слова в память машины
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t asm_setun(char *path) {
+
+	FILE *file;
+	int8_t r;
+
+	file = fopen(path, "r");
+	if( file == NULL ) {
+		printf(" --- ERROR open '%s'\r\n", path);
+		return -1;
+	}
+	r = asm_file(file, path);
+	fclose(file);
+	return r;
+}
+
+/**
+ * Записать файл девятеричных слов
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t asm_write(char *path, trishort *w, uint8_t n) {
+
+	FILE *file;
+	uint8_t line[NONARY_LINE];
+	uint8_t i;
+
+	file = fopen(path, "w");
+	if( file == NULL ) {
+		printf(" --- ERROR open '%s'\r\n", path);
+		return -1;
+	}
+	for(i=0; i<n; i++) {
+		nonary_put(line, w[i]);
+		fwrite(line, 1, NONARY_LINE, file);
+	}
+	if( fclose(file) != 0 ) {
+		printf(" --- ERROR write '%s'\r\n", path);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Записать программу в файлы '*.txs':
+ * слова FRAM в path, зоны барабана в path без '.txs' с '_drum_1w.txs'
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t asm_save_txs(char *path) {
+
+	char zpath[1024];
+	size_t n;
+	uint8_t z;
+
+	if( asm_write(path, asm_fram, asm_fram_n) != 0 ) {
+		return -1;
+	}
+	n = strlen(path);
+	if( n >= 4 && strcmp(path + n - 4, ".txs") == 0 ) {
+		n -= 4;
+	}
+	for(z=0; z<NUMBER_ZONE_DRUM; z++) {
+		if( asm_drum_n[z] == 0 ) {
+			continue;
+		}
+		snprintf(zpath, sizeof(zpath), "%.*s_drum_%s.txs", (int)n, path, asm_drum_name[z]);
+		if( asm_write(zpath, asm_drum[z], SIZE_ZONE_TRIT_DRUM) != 0 ) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/** *********************************************
+ *  Бинарный образ машины "Сетунь-1958"
+ *  ---------------------------------------------
+ *
+ *  Файл образа: заголовок, регистры K,F,C,W,S,R,MB,MR,
+ *  счетчик операций, время машины, позиции лент устройств,
+ *  регистры пишущей машинки, обмены устройств со словами зон вывода,
+ *  память FRAM и DRUM в порядке байт машины хоста.
+ *  Образ читается одной операцией read().
+ *  Этот же образ служит контрольной точкой длительных программ.
+ */
+#define IMAGE_MAGIC			(0x4E555453)	/* "STUN" */
+#define IMAGE_VERSION		(8)				/* версия формата образа */
+#define IMAGE_NUMBER_REGS	(8)				/* количество регистров в образе */
+
+typedef struct image_hdr {
+	uint32_t magic;		/* сигнатура образа */
+	uint16_t version;	/* версия формата образа */
+	uint16_t hsize;		/* размер заголовка */
+	uint32_t size;		/* размер данных после заголовка */
+	uint32_t crc;		/* контрольная сумма данных после заголовка */
+} image_hdr_t;
+
+typedef struct image {
+	image_hdr_t hdr;
+	uint8_t  reg_l[IMAGE_NUMBER_REGS];		/* длины регистров */
+	trilong  reg_tb[IMAGE_NUMBER_REGS];		/* поля битов регистров */
+	uint64_t opers;							/* счетчик выполненных операций */
+	uint64_t cycles;						/* время машины в тактах */
+	uint64_t ptr_pos[2];					/* позиции лент ptr0, ptr1 */
+	uint64_t out_pos[3];					/* позиции вывода ptp0, lpt0, tty0 */
+	uint64_t up_pos;						/* позиция набора пульта up0 */
+	uint64_t ur_pos[2];						/* позиции магнитных лент ur0, ur1 */
+	uint8_t  io_busy[DEV_NUMBER];			/* обмены устройств */
+	uint8_t  io_fz[DEV_NUMBER];
+	uint64_t io_done[DEV_NUMBER];
+	trishort io_zone[DEV_NUMBER][SIZE_ZONE_TRIT_DRUM];	/* слова зон вывода при постановке обмена */
+	uint8_t  tw_sw[3];						/* регистры пишущей машинки */
+	trishort fram[SIZE_PAGE_TRIT_FRAM][SIZE_PAGES_FRAM];
+	trishort drum[NUMBER_ZONE_DRUM][SIZE_ZONE_TRIT_DRUM];
+} image_t;
+
+static image_t image_buf; /* буфер образа для чтения и записи */
+
+/**
+ * Контрольная сумма FNV-1a данных образа
+ */
+uint32_t image_crc(uint8_t *p, uint32_t n) {
+
+	uint32_t h = 2166136261u;
+
+	while( n-- ) {
+		h ^= *p++;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/**
+ * Регистры машины в порядке записи в образ
+ */
+trs_t * image_reg(uint8_t i) {
+	switch( i ) {
+		case 0: return &K;
+		case 1: return &F;
+		case 2: return &C;
+		case 3: return &W;
+		case 4: return &S;
+		case 5: return &R;
+		case 6: return &MB;
+		default: return &MR;
+	}
+}
+
+/**
+ * Сохранить состояние машины в образ
+ */
+void image_from_setun(image_t *img) {
+
+	uint8_t i;
+
+	memset(img,0,sizeof(image_t));
+
+	img->hdr.magic   = IMAGE_MAGIC;
+	img->hdr.version = IMAGE_VERSION;
+	img->hdr.hsize   = sizeof(image_hdr_t);
+	img->hdr.size    = sizeof(image_t) - sizeof(image_hdr_t);
+
+	for(i=0; i<IMAGE_NUMBER_REGS; i++) {
+		img->reg_l[i]  = image_reg(i)->l;
+		img->reg_tb[i] = image_reg(i)->tb;
+	}
+	img->opers    = opers_count;
+	img->cycles   = cycles;
+	img->ptr_pos[0] = ptr_dev[0].offset;
+	img->ptr_pos[1] = ptr_dev[1].offset;
+	img->out_pos[0] = out_dev[OUT_PTP0].offset;
+	img->out_pos[1] = out_dev[OUT_LPT0].offset;
+	img->out_pos[2] = out_dev[OUT_TTY0].offset;
+	img->up_pos     = up_dev.offset;
+	img->ur_pos[0]  = ur_dev[0].offset;
+	img->ur_pos[1]  = ur_dev[1].offset;
+	for(i=0; i<io_count; i++) {
+		img->io_busy[i] = io_devs[i].busy;
+		img->io_fz[i]   = io_devs[i].fz;
+		img->io_done[i] = io_devs[i].done;
+		memcpy(img->io_zone[i], io_devs[i].zone, SIZE_ZONE_BYTES);
+	}
+	img->tw_sw[0] = russian_latin_sw;
+	img->tw_sw[1] = letter_number_sw;
+	img->tw_sw[2] = color_sw;
+	memcpy(img->fram, mem_fram, sizeof(mem_fram));
+	for(i=0; i<NUMBER_ZONE_DRUM; i++) {
+		memcpy(img->drum[i], mem_drum[i], SIZE_ZONE_BYTES);
+	}
+
+	img->hdr.crc = image_crc((uint8_t *)img + sizeof(image_hdr_t), img->hdr.size);
+}
+
+/**
+ * Восстановить состояние машины из образа
+ */
+void image_to_setun(image_t *img) {
+
+	uint8_t i;
+
+	for(i=0; i<IMAGE_NUMBER_REGS; i++) {
+		image_reg(i)->l  = img->reg_l[i];
+		image_reg(i)->tb = img->reg_tb[i];
+	}
+	opers_count      = img->opers;
+	cycles           = img->cycles;
+	ptr_seek(&ptr_dev[0], img->ptr_pos[0]);
+	ptr_seek(&ptr_dev[1], img->ptr_pos[1]);
+	out_seek(&out_dev[OUT_PTP0], img->out_pos[0]);
+	out_seek(&out_dev[OUT_LPT0], img->out_pos[1]);
+	out_seek(&out_dev[OUT_TTY0], img->out_pos[2]);
+	ptr_seek(&up_dev, img->up_pos);
+	ur_dev[0].offset = img->ur_pos[0];
+	ur_dev[1].offset = img->ur_pos[1];
+	io_state_set(img->io_busy, img->io_fz, img->io_done, img->io_zone);
+	russian_latin_sw = img->tw_sw[0];
+	letter_number_sw = img->tw_sw[1];
+	color_sw         = img->tw_sw[2];
+	memcpy(mem_fram, img->fram, sizeof(mem_fram));
+	for(i=0; i<NUMBER_ZONE_DRUM; i++) {
+		drum_zone_set(i, img->drum[i]);
+	}
+
+	FRAM_TOUCH_ALL();
+	DRUM_TOUCH_ALL();
+}
+
+/**
+ * Проверить заголовок и контрольную сумму образа
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t image_check(image_t *img) {
+
+	if( img->hdr.magic != IMAGE_MAGIC ||
+		img->hdr.version != IMAGE_VERSION ||
+		img->hdr.hsize != sizeof(image_hdr_t) ||
+		img->hdr.size != sizeof(image_t) - sizeof(image_hdr_t)
+	  ) {
+		return -1;
+	}
+	if( img->hdr.crc != image_crc((uint8_t *)img + sizeof(image_hdr_t), img->hdr.size) ) {
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Записать бинарный образ машины в файл.
+ * Образ пишется во временный файл и заменяет прежний
+ * переименованием, файл всегда содержит целый образ.
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t save_image(char *path) {
+
+	int fd;
+	ssize_t n;
+	char tmp_path[1024];
+
+	image_from_setun(&image_buf);
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if( fd < 0 ) {
+		printf(" --- ERROR open '%s'\r\n", tmp_path);
+		return -1;
+	}
+	n = write(fd, &image_buf, sizeof(image_t));
+	if( (n != (ssize_t)sizeof(image_t)) || (fsync(fd) != 0) ) {
+		close(fd);
+		unlink(tmp_path);
+		printf(" --- ERROR write '%s'\r\n", tmp_path);
+		return -1;
+	}
+	close(fd);
+
+	if( rename(tmp_path, path) != 0 ) {
+		unlink(tmp_path);
+		printf(" --- ERROR rename '%s'\r\n", path);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Прочитать бинарный образ машины из файла
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t load_image(char *path) {
+
+	int fd;
+	ssize_t n;
+	uint8_t i;
+
+	fd = open(path, O_RDONLY);
+	if( fd < 0 ) {
+		printf(" --- ERROR open '%s'\r\n", path);
+		return -1;
+	}
+	n = read(fd, &image_buf, sizeof(image_t));
+	close(fd);
+
+	if( n != (ssize_t)sizeof(image_t) || image_check(&image_buf) != 0 ) {
+		printf(" --- ERROR image '%s'\r\n", path);
+		return -1;
+	}
+
+	/* Барабан в файле не заменяется барабаном из образа */
+	if( drum_map != NULL ) {
+		for(i=0; i<NUMBER_ZONE_DRUM; i++) {
+			memcpy(image_buf.drum[i], mem_drum[i], SIZE_ZONE_BYTES);
+		}
+		printf(" --- Image '%s': drum kept from drum file\r\n", path);
+	}
+
+	image_to_setun(&image_buf);
+	return 0;
+}
+
+/** *********************************************
+ *  Эталонный образ для быстрого сброса машины
+ *  ---------------------------------------------
+ *
+ *  Подготовленное состояние машины сохраняется в памяти,
+ *  сброс восстанавливает его копированием памяти целиком
+ *  или только изменённых строк FRAM и зон DRUM.
+ */
+static image_t golden; /* эталонный образ машины */
+
+/**
+ * Запомнить текущее состояние машины как эталонное
+ */
+void golden_save(void) {
+
+	out_flush_all();
+	image_from_setun(&golden);
+
+	fram_dirty[0] = fram_dirty[1] = 0;
+	drum_dirty[0] = drum_dirty[1] = 0;
+}
+
+/**
+ * Восстановить регистры из эталонного образа
+ */
+void golden_regs(void) {
+
+	uint8_t i;
+
+	for(i=0; i<IMAGE_NUMBER_REGS; i++) {
+		image_reg(i)->l  = golden.reg_l[i];
+		image_reg(i)->tb = golden.reg_tb[i];
+	}
+	opers_count      = golden.opers;
+	cycles           = golden.cycles;
+	ptr_seek(&ptr_dev[0], golden.ptr_pos[0]);
+	ptr_seek(&ptr_dev[1], golden.ptr_pos[1]);
+	out_seek(&out_dev[OUT_PTP0], golden.out_pos[0]);
+	out_seek(&out_dev[OUT_LPT0], golden.out_pos[1]);
+	out_seek(&out_dev[OUT_TTY0], golden.out_pos[2]);
+	ptr_seek(&up_dev, golden.up_pos);
+	ur_dev[0].offset = golden.ur_pos[0];
+	ur_dev[1].offset = golden.ur_pos[1];
+	io_state_set(golden.io_busy, golden.io_fz, golden.io_done, golden.io_zone);
+	russian_latin_sw = golden.tw_sw[0];
+	letter_number_sw = golden.tw_sw[1];
+	color_sw         = golden.tw_sw[2];
+}
+
+/**
+ * Эталонный сброс: восстановить всю память и регистры
+ */
+void golden_reset(void) {
+
+	uint8_t i;
+
+	golden_regs();
+	memcpy(mem_fram, golden.fram, sizeof(mem_fram));
+	for(i=0; i<NUMBER_ZONE_DRUM; i++) {
+		drum_zone_set(i, golden.drum[i]);
+	}
+
+	fram_dirty[0] = fram_dirty[1] = 0;
+	drum_dirty[0] = drum_dirty[1] = 0;
+}
+
+/**
+ * Эталонный сброс только изменённых строк FRAM и зон DRUM
+ */
+void golden_reset_dirty(void) {
+
+	uint8_t i;
+	uint8_t j;
+	uint64_t m;
+
+	golden_regs();
+
+	for(i=0; i<2; i++) {
+		m = fram_dirty[i];
+		while( m ) {
+			j = (i<<6) + __builtin_ctzll(m);
+			m &= m - 1;
+			if( j < SIZE_PAGE_TRIT_FRAM ) {
+				memcpy(mem_fram[j], golden.fram[j], sizeof(mem_fram[0]));
+			}
+		}
+		fram_dirty[i] = 0;
+
+		m = drum_dirty[i];
+		while( m ) {
+			j = (i<<6) + __builtin_ctzll(m);
+			m &= m - 1;
+			if( j < NUMBER_ZONE_DRUM ) {
+				drum_zone_set(j, golden.drum[j]);
+			}
+		}
+		drum_dirty[i] = 0;
+	}
+}
+
+/**
+ * Записать контрольную точку машины
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t checkpoint_setun_1958(char *path) {
+	out_flush_all(); /* позиции вывода в образе совпадают с файлами */
+	return save_image(path);
+}
+
+/**
+ * Продолжить с контрольной точки машины
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t restore_setun_1958(char *path) {
+
+	if( load_image(path) != 0 ) {
+		return -1;
+	}
+	if( checkpoint_every > 0 ) {
+		checkpoint_next = (opers_count / checkpoint_every + 1) * checkpoint_every;
+	}
+	return 0;
+}
+
+/** *********************************************
+ *  Тестирование виртуальной машины "Сетунь-1958"
+ *  типов данных, функции
+ *  ---------------------------------------------
+ */
+void Triniti_tests( void ) {
+
+	printf("\n --- START Triniti tests VM SETUN-1958 --- \n");
+
+	printf("pR=%08p\n",&R);
+
+	//t1 Point address
+	printf("\nt1 --- Point type addr\n");
+	addr pM;
+	pM = 0xffffffff;
+	printf("pM = 0xffffffff [%ji]\n",pM);
+
+	//t2 XOR-троичная двоичными операциями
+	printf("\nt2 --- XOR\n");
+	int16_t a,b,c;
+	printf("a = 0x10\n");
+	printf("b = 0x10\n");
+	printf("c = a | b\n");
+	printf("c = c ^ 0x11\n");	
+	a = (int16_t)0x10;
+	b = (int16_t)0x10;
+	c = a | b;
+	c = c ^ (int16_t)0x11;
+	printf("a xor b = c  0x%x\n",(int8_t)c );
+
+	//t3 POW3
+	printf("\nt3 --- POW3\n");
+	printf("pow3(3)=%li\n", (int32_t)pow3(3));
+
+	//t4 trit2bit
+	printf("\nt4 --- trit2bit()\n");
+	trs_t k;
+	k.tb = 0;
+	printf("trit2bit(0)=%i\n", trit2bit(k));
+	k.tb = 1;
+	printf("trit2bit(1)=%i\n", trit2bit(k));
+	k.tb = 2;
+	printf("trit2bit(2)=%i\n", trit2bit(k));
+	k.tb = 3;
+	printf("trit2bit(3)=%i\n", trit2bit(k));
+
+	//t5
+	printf("\nt5 --- bit2trit()\n");
+	k = bit2trit(0);
+	printf("bit2trit(0)=%lu\n", k.tb);
+	k = bit2trit(1);
+	printf("bit2trit(1)=%lu\n", k.tb);
+	k = bit2trit(-1);
+	printf("bit2trit(-1)=%lu\n", k.tb);
+
+	//t6
+	printf("\nt6 --- printf long int\n");
+	long int ll = 	0x00000001lu;
+	printf("long int ll = 	0x00000001lu\n");
+	printf("ll=%lu\n",ll);
+	ll <<= 2;
+	printf("ll=%lu\n",ll);
+	ll <<= 1;
+	printf("ll=%lu\n",ll);
+
+	//t7
+	printf("\nt7 --- sng()\n");
+	k.tb = 0;
+	printf("k.tb = 0\n");
+	printf("sgn(k)=%i\n",sgn(k));
+	k.tb = 1;
+	printf("k.tb = 1\n");
+	printf("sgn(k)=%i\n",sgn(k));
+	k.tb = 2;
+	printf("k.tb = 2\n");
+	printf("sgn(k)=%i\n",sgn(k));
+	k.tb = 3;
+	printf("k.tb = 3\n");
+	printf("sgn(k)=%i\n",sgn(k));
+
+	//t8	
+	printf("\nt8 --- st_fram()\n");
+	C.l = 5;
+	C.tb = 0;
+	//	
+	k.l = 9;
+	k.tb = 4;
+	//
+	view_short_reg(&C,"C =");
+	view_short_reg(&k,"k =");
+	printf("st_fram(C,k)\n");
+	st_fram(C,k);
+
+	//t9	
+	printf("\nt9 --- control_trs()\n");
+	C.l = 5;
+	C.tb = 0;
+
+	C.l = 5;
+	C.tb = 0;
+
+	//t control
+	trs_t anw;
+	anw.l = 9;
+	anw.tb = 0;
+	//
+	F.l = 5;
+	F.tb = 2;
+	//	
+	k.l = 9;
+	k.tb = 2<<8;
+	k.tb |= 2;
+	view_short_reg(&k,"k");
+	anw = control_trs( k );
+	view_short_reg(&C,"C");
+	view_short_reg(&F,"F");
+	view_short_reg(&anw,"anw");
+
+	//t10
+	printf("\nt10 --- get_trit()\n");
+	uint8_t fl;
+	view_short_reg(&k,"k");
+	fl = get_trit(k,9);
+	printf(" fl=%i",fl);
+	fl = get_trit(k,8);
+	printf(" fl=%i",fl);
+	fl = get_trit(k,7);
+	printf(" fl=%i",fl);
+	fl = get_trit(k,6);
+	printf(" fl=%i",fl);
+	fl = get_trit(k,5);
+	printf(" fl=%i",fl);
+	fl = get_trit(k,4);
+	printf(" fl=%i",fl);
+	fl = get_trit(k,3);
+	printf(" fl=%i",fl);
+	fl = get_trit(k,2);
+	printf(" fl=%i",fl);
+	fl = get_trit(k,1);
+	printf(" fl=%i",fl);
+	printf("\n");
+
+	//t11
+	printf("\nt11 --- slice_trs()\n");
+	trs_t q;
+	view_short_reg(&k,"k");
+	q = slice_trs(k,1,9);
+	view_short_reg(&q,"q");
+	q = slice_trs(k,6,8);
+	view_short_reg(&q,"q");
+	q = slice_trs(k,5,5);
+	view_short_reg(&q,"q");
+	q = slice_trs(k,9,9);
+	view_short_reg(&q,"?q");
+	q = slice_trs(k,4,4);
+	view_short_reg(&q,"??q");
+
+	//t12
+	printf("\nt12 --- set_trit()\n");
+	trs_t H;
+	H.l=9;
+	H.tb = 0;
+	set_trit( &H, 1, 1);
+	set_trit( &H, 2, -1);
+	set_trit( &H, 3, 0);
+	set_trit( &H, 9, -1);
+	view_short_reg(&H,"H");
+
+	//t13 fram
+	printf("\nt13 --- st_fram() ld_fram\n");
+	
+	int status = 0;
+	int cdoper = 0;
+	int cnt = 0;
+
+	status += 0;
+	cdoper += 0;
+	cnt += 0;
+
+	trs_t ea;
+	clear(&ea);
+	ea.l = 5;
+
+	trs_t v;
+	clear(&v);
+	v.l = 9;
+	set_trit(&v,1,-1);
+	set_trit(&v,5,1);
+	set_trit(&v,9,0);
+	//
+	st_fram( ea,v );
+	v.l = 9;
+	set_trit(&v,1,0);
+	set_trit(&v,5,-1);
+	set_trit(&v,9,10);
+	inc_trs(&ea);
+	st_fram( ea,v );
+
+	//t14 fram
+	printf("\nt14 --- st_fram() ld_fram\n");
+	
+	clear(&ea);
+	clear(&R);
+
+	ea.l = 5;
+	set_trit(&ea,5,1);
+	R.l = 18;
+	set_trit(&R,1,1);
+	set_trit(&R,18,-1);
+
+	view_short_reg(&ea,"st ea");
+	view_short_reg(&R,"st R");
+
+	st_fram(ea,R);
+	R = ld_fram(ea);
+	view_short_reg(&ea," ld ea");
+	view_short_reg(&R," ld R");
+
+	//t15 fram
+	printf("\nt15 --- st_fram() ld_fram\n");
+
+	set_trit(&R,1,1);
+	set_trit(&R,10,-1);
+	inc_trs(&ea);
+	view_short_reg(&ea,"ea=");
+	view_short_reg(&R,"R=");	
+	printf("st_fram(ea,R)\n");
+	st_fram(ea,R);
+	R = ld_fram(ea);
+	printf("R = ld_fram(ea)\n");
+	view_short_reg(&R,"R");
+
+	//t16 fram
+	printf("\nt16 --- smtr() ld_fram\n");
+
+	//
+	trs_t X;
+	trs_t in;
+
+	printf("X = smtr(\"0000-----\")\n");
+    
+	X = smtr("0000-----");
+
+	in = shift_trs(X, 1);
+	view_short_reg(&in,"in");
+	in = shift_trs(X, 2);
+	view_short_reg(&in,"in");
+	in = shift_trs(X, 3);
+	view_short_reg(&in,"in");
+	in = shift_trs(X, 4);
+	view_short_reg(&in,"in");
+	in = shift_trs(X, 5);
+	view_short_reg(&in,"in");
+
+	set_trit(&X,9,-1);
+	in = shift_trs(X, -1);
+	view_short_reg(&in,"in");
+	in = shift_trs(X, -2);
+	view_short_reg(&in,"in");
+	in = shift_trs(X, -3);
+	view_short_reg(&in,"in");
+	in = shift_trs(X, -4);
+	view_short_reg(&in,"in");
+	in = shift_trs(X, -5);
+	view_short_reg(&in,"in");
+	in = shift_trs(X, -6);
+	view_short_reg(&in,"in");
+	in = shift_trs(X, -7);
+	view_short_reg(&in,"in");
+
+	printf("X = smtr(\"00000000-\")\n");
+
+    X = smtr("00000000-");
+
+	clear(&in);
+	in.l=9;
+	set_trit(&in,9,-1);
+	view_short_reg(&in," in");
+	view_short_reg(&X," X");
+	in = add_trs(X, in);
+	view_short_reg(&in,"add in");
+
+	set_trit(&in,9,-1);
+
+	view_short_reg(&in," in");
+	view_short_reg(&X," X");
+	in = add_trs(X, in);
+	view_short_reg(&in,"add in");
+	in = add_trs(in, in);
+	view_short_reg(&in,"add in");
+
+
+	//
+	clear(&in);
+	clear(&X);
+	in.l=5;
+	X.l=9;
+    
+	in = smtr("-----");
+    X = smtr("0000-----");
+
+	view_short_reg(&in,"in=");
+	view_short_reg(&X,"X=");
+
+	clean_fram();
+
+	in.l = 18;
+	inc_trs(&in);
+	view_short_reg(&in," m in");
+	inc_trs(&in);
+	view_short_reg(&in," m in");
+
+	int l;
+	clean_fram();
+	clear(&X);
+	clear(&in);
+	X.l  = 18;
+	set_trit(&X,18,-1);
+	set_trit(&X,1,-1);
+	in = smtr("00011");
+
+	st_fram(in,X);
+	set_trit(&in,1,0);
+	set_trit(&in,2,0);
+	set_trit(&in,3,0);
+	set_trit(&in,4,1);
+	set_trit(&in,5,0);
+	st_fram(in,X);
+
+	view_short_reg(&in," in");
+	view_short_reg(&X,"  X");
+
+
+	//t17 fram
+	printf("\nt17 --- Write/Read fram\n");
+
+	clear(&X);
+	clear(&in);
+	X.l  = 18;
+	set_trit(&X,1,-1);
+	set_trit(&X,18,-1);
+	in.l = 5;
+	set_trit(&in,1,-1);
+	set_trit(&in,2,-1);
+	set_trit(&in,3,-1);
+	set_trit(&in,4,-1);
+	set_trit(&in,5,-1);
+
+	printf("\nst_fram(in,X)\r\n");
+
+	for(l=-121;l<=+121;l++) { //TRIT5_MIN TRIT5_MAX
+
+		if( get_trit_int(in,5) == -1 ) {
+			view_short_reg(&in," addr");
+			st_fram(in,X);
+		}
+		inc_trs(&in);
+		inc_trs(&X);
+	}
+	
+	dump_fram();
+
+	//
+	view_short_reg(&k,"in k");
+	dec_trs(&k);
+	dec_trs(&k);
+	view_short_reg(&k,"out k");
+
+	printf("\n --- VM Setun-1958 Executes --- \n");
+
+	reset_setun_1958();
+
+	clear(&k);
+	k.l = 9;
+	set_trit(&k,1,-1);
+	set_trit(&k,2,-1);
+	set_trit(&k,3,-1);
+	set_trit(&k,4,-1);
+	set_trit(&k,5,-1);
+	set_trit(&k,6,-1);
+	set_trit(&k,7,-1);
+	set_trit(&k,8,-1);
+	set_trit(&k,9,-1);
+
+	//view_short_reg(&k," k");
+	//C = control_trs(k);
+	//view_short_reg(&C," C");
+
+	//for(l=TRIT9_MIN;l<=TRIT9_MAX;l++) {
+	//	inc_trs(&k);
+	//	status = execute_trs( control_trs(k) );
+	//}
+
+	view_short_regs();
+
+	//t
+	clean_drum();
+	clean_fram();
+	//printf(" --- DUMP MEM FRAM --- \n");
+	//dump_fram();
+	//dump_drum();
+
+	printf("\n --- TEST electrified_typewriter() --- \n");
+
+	trs_t cp;
+	clear(&cp);
+	cp.l = 3;
+	set_trit(&cp,1,-1);
+	set_trit(&cp,2,-1);
+	set_trit(&cp,3,-1);
+
+	uint8_t cc;
+
+	set_trit(&cp,1,1);
+	set_trit(&cp,2,1);
+	set_trit(&cp,3,0);
+	electrified_typewriter(cp,0);
+
+	set_trit(&cp,1,-1);
+	set_trit(&cp,2,-1);
+	set_trit(&cp,3,-1);
+	for(cc=0;cc<27;cc++) {
+		if( trs_to_digit(&cp) != 12 || trs_to_digit(&cp) != 11 ) {
+			electrified_typewriter(cp,0);
+		}
+		inc_trs(&cp);
+	}
+
+	set_trit(&cp,1,1);
+	set_trit(&cp,2,1);
+	set_trit(&cp,3,-1);
+	electrified_typewriter(cp,0);
+
+	set_trit(&cp,1,-1);
+	set_trit(&cp,2,-1);
+	set_trit(&cp,3,-1);
+	for(cc=0;cc<27;cc++) {
+		if( trs_to_digit(&cp) != 12 || trs_to_digit(&cp) != 11 ) {
+			electrified_typewriter(cp,0);
+		}
+		inc_trs(&cp);
+	}
+
+	set_trit(&cp,1,1);
+	set_trit(&cp,2,1);
+	set_trit(&cp,3,0);
+	electrified_typewriter(cp,1);
+
+	set_trit(&cp,1,-1);
+	set_trit(&cp,2,-1);
+	set_trit(&cp,3,-1);
+	for(cc=0;cc<27;cc++) {
+		if( trs_to_digit(&cp) != 12 || trs_to_digit(&cp) != 11 ) {
+			electrified_typewriter(cp,1);
+		}
+		inc_trs(&cp);
+	}
+
+	set_trit(&cp,1,1);
+	set_trit(&cp,2,1);
+	set_trit(&cp,3,-1);
+	electrified_typewriter(cp,1);
+
+	set_trit(&cp,1,-1);
+	set_trit(&cp,2,-1);
+	set_trit(&cp,3,-1);
+	for(cc=0;cc<27;cc++) {
+		if( trs_to_digit(&cp) != 12 || trs_to_digit(&cp) != 11 ) {
+			electrified_typewriter(cp,1);
+		}
+		inc_trs(&cp);
+	}
+	out_flush(&out_dev[OUT_TTY0]);
+
+	printf("\nt15 --- inc_trs()\n");
+
+	//uint8_t cmd[20];
+	//trs_t dst;
+	//dst.l = 9;
+	//dst.tb = 0;
+	trs_t inr;
+	inr.l = 5;
+	set_trit(&inr,1,-1);
+	set_trit(&inr,2,-1);
+	set_trit(&inr,3,-1);
+	set_trit(&inr,4,-1);
+	set_trit(&inr,5,0);
+
+	uint8_t mm;
+	for(mm=1;mm<=54;mm++) {
+		view_short_reg(&inr,"inr");
+		inc_trs(&inr);
+	}
+
+	//dump_fram();
+	//dump_fram();
+	printf("\n --- Size bytes DRUM, FRAM --- \n");
+	printf(" - mem_drum=%f\r\n", (float)(SIZE_DRUM_BYTES) );
+	printf(" - mem_fram=%f\r\n", (float)(sizeof(mem_fram)) );
+
+	trs_t zd;
+	zd.l = 4;
+	set_trit(&zd,1,1);
+	set_trit(&zd,2,1);
+	set_trit(&zd,3,1);
+	set_trit(&zd,4,1);
+	printf(" - zone_drum_to_index()=%i\r\n",zone_drum_to_index(zd) );
+
+	trs_t rd;
+	rd.l = 4;
+	set_trit(&rd,1,1);
+	set_trit(&rd,2,1);
+	set_trit(&rd,3,1);
+	set_trit(&rd,4,1);
+	printf(" - row_drum_to_index()=%i\r\n",row_drum_to_index(rd) );
+
+	trs_t zr;
+	zr.l = 1;
+	set_trit(&zr,1,-1);
+	printf(" - zone_fram_to_index()=%i\r\n",zone_fram_to_index(zr) );
+	set_trit(&zr,1,0);
+	printf(" - zone_fram_to_index()=%i\r\n",zone_fram_to_index(zr) );
+	set_trit(&zr,1,1);
+	printf(" - zone_fram_to_index()=%i\r\n",zone_fram_to_index(zr) );
+
+	trs_t rr;
+	rr.l = 4;
+
+	set_trit(&rr,1,-1);
+	set_trit(&rr,2,-1);
+	set_trit(&rr,3,-1);
+	set_trit(&rr,4,0);
+	printf(" - row_fram_to_index()=%i\r\n",row_fram_to_index(rr) );
+
+	set_trit(&rr,1,0);
+	set_trit(&rr,2,0);
+	set_trit(&rr,3,0);
+	set_trit(&rr,4,0);
+	printf(" - row_fram_to_index()=%i\r\n",row_fram_to_index(rr) );
+
+	set_trit(&rr,1,1);
+	set_trit(&rr,2,1);
+	set_trit(&rr,3,1);
+	set_trit(&rr,4,1);
+	printf(" - row_fram_to_index()=%i\r\n",row_fram_to_index(rr) );
+
+
+	printf(" - 1. \r\n");
+	trs_t aa;
+	aa.l = 5;
+	set_trit(&aa,1,-1);
+	set_trit(&aa,2,-1);
+	set_trit(&aa,3,1);
+	set_trit(&aa,4,1);
+	set_trit(&aa,5,-1);
+
+	R.tb = 0;
+	set_trit(&R,1,-1);
+	set_trit(&R,18,-1);
+	view_short_reg(&R,"R");
+
+	st_fram(aa,R);
+	R = ld_fram(aa);
+	view_short_reg(&aa,"aa");
+	view_short_reg(&R,"R");
+
+	printf(" - 2. \r\n");
+	set_trit(&aa,1,-1);
+	set_trit(&aa,2,-1);
+	set_trit(&aa,3,-1);
+	set_trit(&aa,4,-1);
+	set_trit(&aa,5,-1);
+
+	st_fram(aa,aa);
+	R = ld_fram(aa);
+	view_short_reg(&aa,"aa");
+	view_short_reg(&R,"R");
+
+	printf(" - 3. \r\n");
+	inc_trs(&aa);
+	st_fram(aa,aa);
+	R = ld_fram(aa);
+	view_short_reg(&aa,"aa");
+	view_short_reg(&R,"R");
+
+	printf(" - 4. \r\n");
+	inc_trs(&aa);
+	st_fram(aa,aa);
+	R = ld_fram(aa);
+	view_short_reg(&aa,"aa");
+	view_short_reg(&R,"R");
+
+	set_trit(&aa,1,1);
+	set_trit(&aa,2,1);
+	set_trit(&aa,3,1);
+	set_trit(&aa,4,1);
+	set_trit(&aa,5,1);
+	st_fram(aa,aa);
+	R = ld_fram(aa);
+	view_short_reg(&aa,"aa");
+	view_short_reg(&R,"R");
+
+	//
+	//dump_fram();
+	//dump_drum();
+
+	printf("\r\n --- smtr() --- \n");
+    R = smtr("-+0+-");
+	view_short_reg(&R,"R");
+
+    R = smtr("---------");
+	view_short_reg(&R,"R");
+
+    R = smtr("+++++++++");
+	view_short_reg(&R,"R");
+	
+	
+	printf("\n\nt17 --- trishort, trilong types data\n");
+	
+	static trishort ts = (trishort)1<<31;
+	static trilong  tl = (trilong)1<<63;
+	
+	printf("sizeof trishort ts=%li\r\n",sizeof(ts)); 
+	printf("sizeof trilong  tl=%li\r\n",sizeof(tl)); 
+
+	for(uint8_t i=0;i<32;i++) {
+		printf(" tl=%016p\r\n",tl); 
+		printf(" ts=tl=%08p\r\n",ts); 
+		printf("\ntl >>= 2\n"); 
+		tl >>=2;
+		ts = tl;
+	}
+
+
+	printf("\n --- STOP Triniti tests VM SETUN-1958 ---\n");
+}
+
+
+/** *********************************************
+ *  Тестирование виртуальной машины "Сетунь-1958"
+ *  типов данных, функции
+ *  ---------------------------------------------
+ */
+void Setun_test_Opers( void ) {
+	
+	trs_t exK;	
+	trs_t oper;
+	trs_t m0;
+	trs_t m1;
+	trs_t addr;
+	trs_t ad1;
+	trs_t ad2;
+	uint8_t ret_exec;
+	
+	//t__ test sub_trs
+	trs_t aaa = smtr("+++++++++000000000");
+	trs_t bbb = smtr("---------+++++++++");
+	trs_t ccc;
+	ccc = sub_trs(aaa,bbb);
+	view_short_reg(&ccc,"c=a-b");
+
+	//t18 test Oper=k6..8[+00] : (A*)=>(S)
+	printf("\nt18: test Oper=k6..8[+00] : (A*)=>(S)\n");	
+	
+	reset_setun_1958(); 
 		
-		switch( codeoper ) {
-			case (+1*9 +0*3 +0):  { // +00 : Посылка в S	(A*)=>(S)
-				printf("   k6..8[+00] : (A*)=>(S)\n");
-				MR = ld_fram(k1_5);
-				copy_trs(&MR,&S);
-				W = sgn_trs(S);
-				C = next_address(C);								
-			} break;
-			case (+1*9 +0*3 +1):  { // +0+ : Сложение в S	(S)+(A*)=>(S)
-				printf("   k6..8[+0+] : (S)+(A*)=>(S)\n");
-				MR = ld_fram(k1_5);				
-				S = add_trs(S,MR);
-				W = sgn_trs(S);
-				if( over(S) > 0 ) {					
-					goto error_over;
-				}
-				C = next_address(C);
-			} break;
-			case (+1*9 +0*3 -1):  { // +0- : Вычитание в S	(S)-(A*)=>(S)
-				printf("   k6..8[+0-] : (S)-(A*)=>(S)\n");
-				MR = ld_fram(k1_5);
+	addr = smtr("00000");
+	view_short_reg(&addr,"addr=");
+	m0 = smtr("+0-0+0-00"); 	
+	st_fram(addr,m0); 
+	view_fram(addr);		
+	
+	addr = smtr("0000+"); 
+	m1 = smtr("00000+000"); 
+	st_fram(addr,m1); 
+	view_fram(addr);		
 				
-				view_short_reg(&S,"S - =");
-				view_short_reg(&MR,"MR=");
+	/* Begin address fram */ 	
+	C = smtr("0000+");	
+	
+	printf("\nreg C = 00001\n"); 
+	
+	/** 
+	* work VM Setun-1958
+	*/
+
+	K = ld_fram(C);
+	view_short_reg(&K,"K=");
+	exK = control_trs(K);	
+	oper = slice_trs(K,6,8);
+	ret_exec = execute_trs(exK,oper);
+	printf("ret_exec = %i\r\n",ret_exec);
+	printf("\n");
+	
+	view_short_regs();
 
-				S = sub_trs(S,MR);				
-				W = sgn_trs(S);
-				if( over(S) > 0 ) {					
-					goto error_over;
-				}
-				C = next_address(C);
-			} break;
-			case (+1*9 +1*3 +0):  { // ++0 : Умножение 0	(S)=>(R); (A*)(R)=>(S)
-				printf("   k6..8[++0] : (S)=>(R); (A*)(R)=>(S)\n");
-				copy_trs(&S,&R);				
-				MR = ld_fram(k1_5);				
-				//S = mul_trs(MR,R); //TODO
-				W = sgn_trs(S);
-				if( over(S) > 0 ) {
-					goto error_over;
-				} 
-				C = next_address(C);
-			} break;
-			case (+1*9 +1*3 +1):  { // +++ : Умножение +	(S)+(A*)(R)=>(S)
-				printf("   k6..8[+++] : (S)+(A*)(R)=>(S)\n");
-				MR = ld_fram(k1_5);				
-				//R = mul_trs(MR,R); //TODO реализовать
-				S = add_trs(S,R);
-				W = sgn_trs(S);
-				if( over(S) > 0 ) {
-					goto error_over;
-				} 
-				C = next_address(C);
-			} break;
-			case (+1*9 -1*3 +0):  { // +-0 : Поразрядное умножение	(A*)[x](S)=>(S)
-				printf("   k6..8[+-0] : (A*)[x](S)=>(S)\n");
-				MR = ld_fram(k1_5);
-				S = xor_trs(MR,S);
-				W = sgn_trs(S);
-				C = next_address(C);
-			} break;
-			case (+1*9 -1*3 +1):  { // +-+ : Посылка в R	(A*)=>(R)
-				printf("   k6..8[+-+] : (A*)=>(R)\n");
-				MR = ld_fram(k1_5);
-				copy_trs(&MR,&R);
-				W = sgn_trs(S);
-				C = next_address(C);
-			} break;
-			case (+1*9 -1*3 -1):  { // +-- : Останов	Стоп; (A*)=>(R)
-				printf("   k6..8[+--] : (A*)=>(R)\n");
-				MR = ld_fram(k1_5);
-				copy_trs(&MR,&R); 
-				C = next_address(C);
-			} break;
-			case (+0*9 +1*3 +0):  { // 0+0 : Условный переход -	A*=>(C) при w=0
-				printf("   k6..8[0+-] : A*=>(C) при w=0\n");
-				uint8_t w;
-				w = sgn(W);
-				if( w==0 ) {
-					copy_trs(&k1_5,&C); 
-				}
-				else {
-					C = next_address(C);
-				} 
-			} break;
-			case (+0*9 +1*3 +1):  { // 0+1 : Условный переход -	A*=>(C) при w=0
-				printf("   k6..8[0+-] : A*=>(C) при w=+1\n");
-				uint8_t w;
-				w = sgn(W);
-				if( w==1 ) {
-					copy_trs(&k1_5,&C); 
-				}
-				else {
-					C = next_address(C);
-				} 
-			} break;
-			case (+0*9 +1*3 -1):  { // 0+- : Условный переход -	A*=>(C) при w=-
-				printf("   k6..8[0+-] : A*=>(C) при w=-1\n");
-				uint8_t w;
-				w = sgn(W);
-				if( w<0 ) {
-					copy_trs(&k1_5,&C); 
-				}
-				else {
-					C = next_address(C);
-				} 
-			} break;
-			case (+0*9 +0*3 +0): { //  000 : Безусловный переход	A*=>(C)
-				printf("   k6..8[000] : A*=>(C)\n");
-				copy_trs(&k1_5,&C); 
-			} break;
-			case (+0*9 +0*3 +1):  { // 00+ : Запись из C	(C)=>(A*)
-				printf("   k6..8[00+] : (C)=>(A*)\n");
-				st_fram(k1_5,C); 
-				C = next_address(C);
-			} break;
-			case (+0*9 +0*3 -1):  { // 00- : Запись из F	(F)=>(A*)
-				printf("   k6..8[00-] : (F)=>(A*)\n");
-				st_fram(k1_5,F);
-				W = sgn_trs(F); 
-				C = next_address(C);
-			} break;
-			case (+0*9 -1*3 +0):  { // 0-0 : Посылка в F	(A*)=>(F)
-				printf("   k6..8[0-0] : (A*)=>(F)\n");
-				MR = ld_fram(k1_5);
-				copy_trs(&MR,&F);
-				W = sgn_trs(F);
-				C = next_address(C);
-			} break;
-			case (+0*9 -1*3 +1):  { // 0-+ : Сложение в F c (C)	(C)+(A*)=>F
-				printf("   k6..8[0-+] : (C)+(A*)=>F\n");
-				MR = ld_fram(k1_5);
-				F = add_trs(C,MR);
-				W = sgn_trs(F);
-				C = next_address(C);
-			} break;
-			case (+0*9 -1*3 -1):  { // 0-- : Сложение в F	(F)+(A*)=>(F)
-				printf("   k6..8[0--] : (F)+(A*)=>(F)\n");
-				MR = ld_fram(k1_5);
-				F = add_trs(F,MR);
-				W = sgn_trs(F);
-				C = next_address(C);
-			} break;
-			case (-1*9 +1*3 +0):  { // -+0 : Сдвиг	Сдвиг (S) на (A*)=>(S)
-				printf("   k6..8[-+0] : (A*)=>(S)\n");
-				/*
-				* Операция сдвига производит сдвиг содержимого регистра S на \N\
-				* разрядов, где N рассматривается как 5-разрядный код, хранящийся в
-				* ячейке Л*, т. е. N = (А*). Сдвиг производится влево при N > 0 и вправо
-				* при N < 0. При N = 0 содержимое регистра 5 не изменяется.
-				*/
-				MR = ld_fram(k1_5);
-				//TODO add  S = shift_trs(S,trit2dec(MR));				
-				W = sgn_trs(S);
-				C = next_address(C);
-			} break;
-			case (-1*9 +1*3 +1):  { // -++ : Запись из S	(S)=>(A*)
-				printf("   k6..8[-++] : (S)=>(A*)\n");
-				st_fram(k1_5,S);
-				W = sgn_trs(S);
-				C = next_address(C);
-			} break;
-			case (-1*9 +1*3 -1):  { // -+- : Нормализация	Норм.(S)=>(A*); (N)=>(S)
-				printf("   k6..8[-+-] : Норм.(S)=>(A*); (N)=>(S)\n");
-				/*
-				* Операция нормализации производит сдвиг (S) при (5) =£= 0 в таком
-				* направлении и на такое число разрядов |iV|, чтобы результат, посылаемый
-				* в ячейку ,4*, был но модулю больше V , но меньше / , т. е. чтобы в д в у х
-				* старших разрядах результата была записана комбинация троичных цифр
-				* 01 или 0 1 . При этом в регистр S посылается число N (5-разрядный код),
-				* знак которого определяется направлением сдвига, а именно: N > 0 при
-				* сдвиге вправо и N < 0 при сдвиге влево. П р и (S) = 0 или при
-				* / <|(*S)| < / в ячейку А* посылается (5), а в регистр S посылается N = 0.				
-				*/
-				//TODO описание операции
-				//
-				W = sgn_trs(S); 
-				C = next_address(C);				
-			} break;
-			case (-1*9 +0*3 +0):  { // -00 : Не задействована	Стоп
-				printf("   k6..8[-00] : STOP\n");
-				return STOP_ERROR;
-			} break;
-			case (-1*9 +0*3 +1):  { // -0+ : Запись на МБ	(Фа*)=>(Мд*)
-				printf("   k6..8[-0+] : (Фа*)=>(Мд*)\n");
-				C = next_address(C);
-			} break;
-			case (-1*9 +0*3 -1):  { // -0- : Считывание с МБ	(Мд*)=>(Фа*)
-				printf("   k6..8[-0-] : (Мд*)=>(Фа*)\n");
-				C = next_address(C);
-			} break;
-			case (-1*9 -1*3 +0):  { // --0 : Не задействована	Стоп
-				printf("   k6..8[--0] : STOP BREAK\n");
-				return STOP_ERROR;
-			} break;
-			case (-1*9 -1*3 +1):  { // --+ : Не задействована	Стоп
-				printf("   k6..8[--+] : STOP BREAK\n");
-				return STOP_ERROR;
-			} break;
-			case (-1*9 -1*3 -1):  { // --- : Не задействована	Стоп
-				printf("   k6..8[---] : STOP BREAK\n");
-				return STOP_ERROR;
-			} break;
-			default: {				// Не допустимая команда машины
-				printf("   k6..8 =[]   : STOP! NO OPERATION\n");
-				return STOP_ERROR; 
-			} 
-			break;
-		}	
-	return OK;				
 	
-	error_over:
-	return STOP_ERROR;				
+	//t19 test Oper=k6..8[+00] : (A*)=>(S)
+	printf("\nt19: test Oper=k6..8[+00] : (A*)=>(S)\n");	
+	
+	reset_setun_1958(); 
 
-}
+	F = smtr("000++"); 	
+		
+	addr = smtr("000++");
+	view_short_reg(&addr,"addr=");
+	m0 = smtr("0++++++++"); 	
+	st_fram(addr,m0); 
 
+	addr = smtr("000--");
+	view_short_reg(&addr,"addr=");
+	m0 = smtr("0++++++++"); 	
+	st_fram(addr,m0); 
 
-/** *********************************************
- *  Тестирование виртуальной машины "Сетунь-1958"
- *  типов данных, функции
- *  ---------------------------------------------
- */
-void Triniti_tests( void ) {
+	addr = smtr("000-0");
+	view_short_reg(&addr,"addr=");
+	m0 = smtr("0--------"); 	
+	st_fram(addr,m0); 
 
-	printf("\n --- START Triniti tests VM SETUN-1958 --- \n");
+	addr = smtr("00000");
+	view_short_reg(&addr,"addr=");
+	m0 = smtr("+0-0+0-00"); 	
+	st_fram(addr,m0); 
+	
+	addr = smtr("0000+"); 
+	m1 = smtr("00000+0-0"); 
+	st_fram(addr,m1); 
 
-	printf("pR=%08p\n",&R);
+	/* Begin address fram */ 	
+	C = smtr("0000+");	
+	
+	printf("\nreg C = 00001\n"); 
+	
+	/** 
+	* work VM Setun-1958
+	*/
+	K = ld_fram(C);	
+	exK = control_trs(K);	
+	view_short_reg(&K,"K=");
+	oper = slice_trs(K,6,8);
+	ret_exec = execute_trs(exK,oper);
+	printf("ret_exec = %i\r\n",ret_exec);
+	printf("\n");
 
-	//t1 Point address
-	printf("\nt1 --- Point type addr\n");
-	addr pM;
-	pM = 0xffffffff;
-	printf("pM = 0xffffffff [%ji]\n",pM);
 
-	//t2 XOR-троичная двоичными операциями
-	printf("\nt2 --- XOR\n");
-	int16_t a,b,c;
-	printf("a = 0x10\n");
-	printf("b = 0x10\n");
-	printf("c = a | b\n");
-	printf("c = c ^ 0x11\n");	
-	a = (int16_t)0x10;
-	b = (int16_t)0x10;
-	c = a | b;
-	c = c ^ (int16_t)0x11;
-	printf("a xor b = c  0x%x\n",(int8_t)c );
+	addr = smtr("0000+"); 
+	m1 = smtr("00000+00+"); 
+	st_fram(addr,m1); 
 
-	//t3 POW3
-	printf("\nt3 --- POW3\n");
-	printf("pow3(3)=%li\n", (int32_t)pow3(3));
+	/* Begin address fram */ 	
+	C = smtr("0000+");	
+	
+	printf("\nreg C = 00001\n"); 
+	
+	/** 
+	* work VM Setun-1958
+	*/
+	K = ld_fram(C);	
+	exK = control_trs(K);	
+	view_short_reg(&K,"K=");
+	oper = slice_trs(K,6,8);
+	ret_exec = execute_trs(exK,oper);
+	printf("ret_exec = %i\r\n",ret_exec);
+	printf("\n");
 
-	//t4 trit2bit
-	printf("\nt4 --- trit2bit()\n");
-	trs_t k;
-	k.tb = 0;
-	printf("trit2bit(0)=%i\n", trit2bit(k));
-	k.tb = 1;
-	printf("trit2bit(1)=%i\n", trit2bit(k));
-	k.tb = 2;
-	printf("trit2bit(2)=%i\n", trit2bit(k));
-	k.tb = 3;
-	printf("trit2bit(3)=%i\n", trit2bit(k));
+	view_short_regs();
+	
+	/* Begin address fram */ 	
+	C = smtr("000+0");	
+	printf("\nreg C = 00010\n"); 
+	
+	addr = smtr("000+0"); 
+	m1 = smtr("00000+0--"); 
+	st_fram(addr,m1); 
 
-	//t5
-	printf("\nt5 --- bit2trit()\n");
-	k = bit2trit(0);
-	printf("bit2trit(0)=%lu\n", k.tb);
-	k = bit2trit(1);
-	printf("bit2trit(1)=%lu\n", k.tb);
-	k = bit2trit(-1);
-	printf("bit2trit(-1)=%lu\n", k.tb);
+	/** 
+	* work VM Setun-1958
+	*/	
+	K = ld_fram(C);	
+	exK = control_trs(K);	
+	view_short_reg(&K,"K=");
+	oper = slice_trs(K,6,8);
+	ret_exec = execute_trs(exK,oper);
+	printf("ret_exec = %i\r\n",ret_exec);
+	printf("\n");
 
-	//t6
-	printf("\nt6 --- printf long int\n");
-	long int ll = 	0x00000001lu;
-	printf("long int ll = 	0x00000001lu\n");
-	printf("ll=%lu\n",ll);
-	ll <<= 2;
-	printf("ll=%lu\n",ll);
-	ll <<= 1;
-	printf("ll=%lu\n",ll);
+	ad1 = smtr("000-0");
+	ad2 = smtr("00+-0");	
+	dumpf(ad1,ad2);
 
-	//t7
-	printf("\nt7 --- sng()\n");
-	k.tb = 0;
-	printf("k.tb = 0\n");
-	printf("sgn(k)=%i\n",sgn(k));
-	k.tb = 1;
-	printf("k.tb = 1\n");
-	printf("sgn(k)=%i\n",sgn(k));
-	k.tb = 2;
-	printf("k.tb = 2\n");
-	printf("sgn(k)=%i\n",sgn(k));
-	k.tb = 3;
-	printf("k.tb = 3\n");
-	printf("sgn(k)=%i\n",sgn(k));
+	view_short_regs();
 
-	//t8	
-	printf("\nt8 --- st_fram()\n");
-	C.l = 5;
-	C.tb = 0;
-	//	
-	k.l = 9;
-	k.tb = 4;
-	//
-	view_short_reg(&C,"C =");
-	view_short_reg(&k,"k =");
-	printf("st_fram(C,k)\n");
-	st_fram(C,k);
+	/* Begin address fram */ 	
+	C = smtr("000++");	
+	printf("\nreg C = 00011\n"); 
+	
+	addr = smtr("000++"); 
+	m1 = smtr("00000++00"); 
+	st_fram(addr,m1); 
 
-	//t9	
-	printf("\nt9 --- control_trs()\n");
-	C.l = 5;
-	C.tb = 0;
+	/** 
+	* work VM Setun-1958
+	*/	
+	K = ld_fram(C);	
+	exK = control_trs(K);	
+	view_short_reg(&K,"K=");
+	oper = slice_trs(K,6,8);
+	ret_exec = execute_trs(exK,oper);
+	printf("ret_exec = %i\r\n",ret_exec);
+	printf("\n");
 
-	C.l = 5;
-	C.tb = 0;
+	ad1 = smtr("000-0");
+	ad2 = smtr("00+-0");	
+	dumpf(ad1,ad2);
 
-	//t control
-	trs_t anw;
-	anw.l = 9;
-	anw.tb = 0;
-	//
-	F.l = 5;
-	F.tb = 2;
-	//	
-	k.l = 9;
-	k.tb = 2<<8;
-	k.tb |= 2;
-	view_short_reg(&k,"k");
-	anw = control_trs( k );
-	view_short_reg(&C,"C");
-	view_short_reg(&F,"F");
-	view_short_reg(&anw,"anw");
+	view_short_regs();
 
-	//t10
-	printf("\nt10 --- get_trit()\n");
-	uint8_t fl;
-	view_short_reg(&k,"k");
-	fl = get_trit(k,9);
-	printf(" fl=%i",fl);
-	fl = get_trit(k,8);
-	printf(" fl=%i",fl);
-	fl = get_trit(k,7);
-	printf(" fl=%i",fl);
-	fl = get_trit(k,6);
-	printf(" fl=%i",fl);
-	fl = get_trit(k,5);
-	printf(" fl=%i",fl);
-	fl = get_trit(k,4);
-	printf(" fl=%i",fl);
-	fl = get_trit(k,3);
-	printf(" fl=%i",fl);
-	fl = get_trit(k,2);
-	printf(" fl=%i",fl);
-	fl = get_trit(k,1);
-	printf(" fl=%i",fl);
-	printf("\n");
+	//t20 test Oper=k6..8[+-0] : (A*)[x](S)=>(S)
+	printf("\nt20: test LDS x; AND y; STS z : (A*)[x](S)=>(S)\n");
+
+	reset_setun_1958();
+
+	addr = smtr("00-00");	/* x */
+	m0 = smtr("+0-+0-+0-");
+	st_fram(addr,m0);
+
+	addr = smtr("00-0+");	/* y */
+	m0 = smtr("+++000---");
+	st_fram(addr,m0);
+
+	C = smtr("0000+");
+	addr = C;
+	m1 = smtr("00-00+000");	/* +00 x */
+	st_fram(addr,m1);
+	addr = next_address(addr);
+	m1 = smtr("00-0++-00");	/* +-0 y */
+	st_fram(addr,m1);
+	addr = next_address(addr);
+	m1 = smtr("00--0-++0");	/* -++ z */
+	st_fram(addr,m1);
+
+	for(uint8_t i=0; i<3; i++) {
+		K = ld_fram(C);
+		exK = control_trs(K);
+		view_short_reg(&K,"K=");
+		oper = slice_trs(K,6,8);
+		ret_exec = execute_trs(exK,oper);
+		printf("ret_exec = %i\r\n",ret_exec);
+	}
+	view_short_reg(&S,"S=");
+
+	/* Поразрядное умножение: ++=+, +0=0, +-=-, --=+ */
+	addr = smtr("00--0");	/* z */
+	m0 = ld_fram(addr);
+	view_fram(addr);
+	ccc = smtr("+0-000-0+");
+	printf("t20: (A*)[x](S) %s\r\n", (m0.tb == ccc.tb) ? "OK" : "ERROR");
+
+	//t21 test Oper=k6..8[+--] : Стоп; (A*)=>(R)
+	printf("\nt21: test Oper=k6..8[+--] : Стоп; (A*)=>(R)\n");
+
+	reset_setun_1958();
+
+	addr = smtr("00000");
+	m0 = smtr("+0-0+0-00");
+	st_fram(addr,m0);
+
+	C = smtr("0000+");
+	addr = C;
+	m1 = smtr("00000+--0");
+	st_fram(addr,m1);
+
+	K = ld_fram(C);
+	exK = control_trs(K);
+	view_short_reg(&K,"K=");
+	oper = slice_trs(K,6,8);
+	ret_exec = execute_trs(exK,oper);
+	printf("ret_exec = %i\r\n",ret_exec);
+	view_short_reg(&R,"R=");
+	view_short_reg(&C,"C=");
+
+	/* Останов с кодом STOP_DONE, C - следующая операция */
+	ad1 = next_address(addr);
+	printf("t21: STOP %s\r\n", ((ret_exec == STOP_DONE) && (C.tb == ad1.tb)) ? "OK" : "ERROR");
+
+	//t22 test Oper=k6..8[-0+], k6..8[-0-] : (Фа*)=>(Мд*), (Мд*)=>(Фа*)
+	printf("\nt22: test DWR, DRD : (Фа*)=>(Мд*), (Мд*)=>(Фа*)\n");
+
+	reset_setun_1958();
 
-	//t11
-	printf("\nt11 --- slice_trs()\n");
-	trs_t q;
-	view_short_reg(&k,"k");
-	q = slice_trs(k,1,9);
-	view_short_reg(&q,"q");
-	q = slice_trs(k,6,8);
-	view_short_reg(&q,"q");
-	q = slice_trs(k,5,5);
-	view_short_reg(&q,"q");
-	q = slice_trs(k,9,9);
-	view_short_reg(&q,"?q");
-	q = slice_trs(k,4,4);
-	view_short_reg(&q,"??q");
+	ad1 = smtr("-0000");
+	m0 = smtr("+0-+0-+0-");
+	st_fram(ad1,m0);
+	ad2 = smtr("-+++0");
+	m0 = smtr("+++000---");
+	st_fram(ad2,m0);
+
+	C = smtr("0000+");
+	addr = C;
+	m1 = smtr("0+00--0+0");	/* -0+ зона 0+00, Фа* = - */
+	st_fram(addr,m1);
+	addr = next_address(addr);
+	m1 = smtr("0+00--0-0");	/* -0- зона 0+00, Фа* = - */
+	st_fram(addr,m1);
 
-	//t12
-	printf("\nt12 --- set_trit()\n");
-	trs_t H;
-	H.l=9;
-	H.tb = 0;
-	set_trit( &H, 1, 1);
-	set_trit( &H, 2, -1);
-	set_trit( &H, 3, 0);
-	set_trit( &H, 9, -1);
-	view_short_reg(&H,"H");
+	K = ld_fram(C);
+	exK = control_trs(K);
+	view_short_reg(&K,"K=");
+	oper = slice_trs(K,6,8);
+	ret_exec = execute_trs(exK,oper);
+	printf("ret_exec = %i\r\n",ret_exec);
 
-	//t13 fram
-	printf("\nt13 --- st_fram() ld_fram\n");
-	
-	int status = 0;
-	int cdoper = 0;
-	int cnt = 0;
+	/* Зона FRAM очищается и читается с барабана */
+	m0 = smtr("000000000");
+	st_fram(ad1,m0);
+	st_fram(ad2,m0);
 
-	status += 0;
-	cdoper += 0;
-	cnt += 0;
+	K = ld_fram(C);
+	exK = control_trs(K);
+	view_short_reg(&K,"K=");
+	oper = slice_trs(K,6,8);
+	ret_exec = execute_trs(exK,oper);
+	printf("ret_exec = %i\r\n",ret_exec);
 
-	trs_t ea;
-	clear(&ea);
-	ea.l = 5;
+	view_fram(ad1);
+	view_fram(ad2);
+	m0 = ld_fram(ad1);
+	m1 = ld_fram(ad2);
+	ccc = smtr("+0-+0-+0-");
+	aaa = smtr("+++000---");
+	printf("t22: DWR, DRD %s\r\n", ((m0.tb == ccc.tb) && (m1.tb == aaa.tb)) ? "OK" : "ERROR");
 
-	trs_t v;
-	clear(&v);
-	v.l = 9;
-	set_trit(&v,1,-1);
-	set_trit(&v,5,1);
-	set_trit(&v,9,0);
-	//
-	st_fram( ea,v );
-	v.l = 9;
-	set_trit(&v,1,0);
-	set_trit(&v,5,-1);
-	set_trit(&v,9,10);
-	inc_trs(&ea);
-	st_fram( ea,v );
+}	
 
-	//t14 fram
-	printf("\nt14 --- st_fram() ld_fram\n");
-	
-	clear(&ea);
-	clear(&R);
+/** *********************************************
+ *  Выполнение двух машин шаг в шаг
+ *  ---------------------------------------------
+ *
+ *  Одна программа выполняется двумя экземплярами машины:
+ *  рабочим циклом и эталонным циклом execute_trs().
+ *  Экземпляр машины - образ image_t, который загружается
+ *  перед каждой серией из N операций и сохраняется после неё.
+ *  Полное состояние экземпляров сравнивается после серии.
+ *  При расхождении серия повторяется по одной операции
+ *  и печатается первая операция с состояниями обеих машин.
+ */
+#define LOCK_EVERY		(1000)	/* операций в серии сравнения */
+#define LOCK_DIFF_MAX	(16)	/* печать различных слов памяти */
 
-	ea.l = 5;
-	set_trit(&ea,5,1);
-	R.l = 18;
-	set_trit(&R,1,1);
-	set_trit(&R,18,-1);
+typedef uint32_t (*lock_engine_t)(uint32_t steps, uint8_t *ret);
 
-	view_short_reg(&ea,"st ea");
-	view_short_reg(&R,"st R");
+static image_t lock_a;		/* рабочая машина	*/
+static image_t lock_b;		/* эталонная машина	*/
+static image_t lock_prev;	/* общее состояние перед серией */
 
-	st_fram(ea,R);
-	R = ld_fram(ea);
-	view_short_reg(&ea," ld ea");
-	view_short_reg(&R," ld R");
+static char *lock_regs[IMAGE_NUMBER_REGS] = { "K", "F", "C", "W", "S", "R", "MB", "MR" };
 
-	//t15 fram
-	printf("\nt15 --- st_fram() ld_fram\n");
+/**
+ * Эталонный цикл: выборка, модификация адреса, операция
+ */
+uint32_t run_reference(uint32_t steps, uint8_t *ret) {
 
-	set_trit(&R,1,1);
-	set_trit(&R,10,-1);
-	inc_trs(&ea);
-	view_short_reg(&ea,"ea=");
-	view_short_reg(&R,"R=");	
-	printf("st_fram(ea,R)\n");
-	st_fram(ea,R);
-	R = ld_fram(ea);
-	printf("R = ld_fram(ea)\n");
-	view_short_reg(&R,"R");
+	uint32_t i;
+	uint8_t ret_exec;
+	trs_t addr;
+	trs_t oper;
 
-	//t16 fram
-	printf("\nt16 --- smtr() ld_fram\n");
+	ret_exec = OK;
+	for(i=0; i<steps; i++) {
+		K = ld_fram(C);
+		addr = control_trs(K);
+		oper = slice_trs(K,6,8);
 
-	//
-	trs_t X;
-	trs_t in;
+		ret_exec = execute_trs(addr,oper);
+		opers_count++;
+		cycles += TIME_OPER;
 
-	printf("X = smtr(\"0000-----\")\n");
-    
-	X = smtr("0000-----");
+		if( (cycles >= event_next) && (event_run() != 0) ) {
+			ret_exec = STOP_ERROR;
+		}
+		if( (ret_exec == STOP_DONE) ||
+			(ret_exec == STOP_OVER) ||
+			(ret_exec == STOP_ERROR)
+		  ) {
+			i++;
+			ret_exec = stop_setun_1958(ret_exec);
+			break;
+		}
+	}
 
-	in = shift_trs(X, 1);
-	view_short_reg(&in,"in");
-	in = shift_trs(X, 2);
-	view_short_reg(&in,"in");
-	in = shift_trs(X, 3);
-	view_short_reg(&in,"in");
-	in = shift_trs(X, 4);
-	view_short_reg(&in,"in");
-	in = shift_trs(X, 5);
-	view_short_reg(&in,"in");
+	*ret = ret_exec;
+	return i;
+}
 
-	set_trit(&X,9,-1);
-	in = shift_trs(X, -1);
-	view_short_reg(&in,"in");
-	in = shift_trs(X, -2);
-	view_short_reg(&in,"in");
-	in = shift_trs(X, -3);
-	view_short_reg(&in,"in");
-	in = shift_trs(X, -4);
-	view_short_reg(&in,"in");
-	in = shift_trs(X, -5);
-	view_short_reg(&in,"in");
-	in = shift_trs(X, -6);
-	view_short_reg(&in,"in");
-	in = shift_trs(X, -7);
-	view_short_reg(&in,"in");
+/**
+ * Выполнить серию операций экземпляром машины img
+ * Счётчики выполнения, трасса, профиль, задержки и диаграммы
+ * только для рабочей машины
+ */
+uint32_t lock_step(image_t *img, lock_engine_t engine, uint32_t steps, uint8_t *ret) {
+
+	exec_stat_t st;
+	uint8_t tr;
+	uint8_t pr;
+	uint8_t lt;
+	uint8_t vc;
+	uint32_t n;
+
+	image_to_setun(img);
+	st = vm_stat;
+	tr = trace_on;
+	pr = prof_on;
+	lt = lat_on;
+	vc = vcd_on;
+	if( engine != run_setun_1958 ) {
+		trace_on = 0;
+		prof_on = 0;
+		lat_on = 0;
+		vcd_on = 0;
+	}
+	n = engine(steps, ret);
+	if( engine != run_setun_1958 ) {
+		vm_stat = st;
+		trace_on = tr;
+		prof_on = pr;
+		lat_on = lt;
+		vcd_on = vc;
+	}
+	image_from_setun(img);
+	return n;
+}
 
-	printf("X = smtr(\"00000000-\")\n");
+/**
+ * Сравнить состояния машин без заголовка образа
+ */
+static inline int lock_cmp(image_t *a, image_t *b) {
+	return memcmp((uint8_t *)a + sizeof(image_hdr_t),
+				  (uint8_t *)b + sizeof(image_hdr_t),
+				  sizeof(image_t) - sizeof(image_hdr_t));
+}
 
-    X = smtr("00000000-");
+/**
+ * Печать различий состояний рабочей a и эталонной b машин
+ */
+void lock_show(image_t *a, image_t *b) {
 
-	clear(&in);
-	in.l=9;
-	set_trit(&in,9,-1);
-	view_short_reg(&in," in");
-	view_short_reg(&X," X");
-	in = add_trs(X, in);
-	view_short_reg(&in,"add in");
+	char *p;
+	uint8_t i;
+	uint8_t j;
+	uint16_t n;
+
+	p = dis_buf;
+	for(i=0; i<IMAGE_NUMBER_REGS; i++) {
+		p = dis_str(p, (a->reg_l[i] != b->reg_l[i] || a->reg_tb[i] != b->reg_tb[i]) ? " * " : "   ");
+		p = dis_str(p, lock_regs[i]);
+		p = dis_str(p, "\t[");
+		p = dis_trits(p, a->reg_tb[i], a->reg_l[i]);
+		p = dis_str(p, "]\t[");
+		p = dis_trits(p, b->reg_tb[i], b->reg_l[i]);
+		p = dis_str(p, "]\n");
+	}
+	p = dis_str(p, (a->cycles != b->cycles) ? " * " : "   ");
+	p = dis_str(p, "time\t");
+	p = dis_int(p, (int64_t)a->cycles, 0, 0);
+	*p++ = '\t';
+	p = dis_int(p, (int64_t)b->cycles, 0, 0);
+	*p++ = '\n';
+	if( memcmp(a->ptr_pos, b->ptr_pos, (uint8_t *)a->fram - (uint8_t *)a->ptr_pos) != 0 ) {
+		p = dis_str(p, " * devices\n");
+	}
 
-	set_trit(&in,9,-1);
+	n = 0;
+	for(i=0; i<SIZE_PAGE_TRIT_FRAM && n<LOCK_DIFF_MAX; i++) {
+		for(j=0; j<SIZE_PAGES_FRAM && n<LOCK_DIFF_MAX; j++) {
+			if( a->fram[i][j] != b->fram[i][j] ) {
+				p = dis_str(p, " * ram(");
+				p = dis_int(p, i - SIZE_PAGE_TRIT_FRAM/2, 3, 0);
+				*p++ = ':';
+				p = dis_int(p, j, 0, 0);
+				p = dis_str(p, ")\t[");
+				p = dis_trits(p, a->fram[i][j], 9);
+				p = dis_str(p, "]\t[");
+				p = dis_trits(p, b->fram[i][j], 9);
+				p = dis_str(p, "]\n");
+				n++;
+			}
+		}
+	}
+	for(i=0; i<NUMBER_ZONE_DRUM && n<LOCK_DIFF_MAX; i++) {
+		for(j=0; j<SIZE_ZONE_TRIT_DRUM && n<LOCK_DIFF_MAX; j++) {
+			if( a->drum[i][j] != b->drum[i][j] ) {
+				p = dis_str(p, " * drum(");
+				p = dis_int(p, i - 36, 3, 0);
+				*p++ = ':';
+				p = dis_int(p, j - 26, 3, 0);
+				p = dis_str(p, ")\t[");
+				p = dis_trits(p, a->drum[i][j], 9);
+				p = dis_str(p, "]\t[");
+				p = dis_trits(p, b->drum[i][j], 9);
+				p = dis_str(p, "]\n");
+				n++;
+			}
+		}
+	}
+	dis_flush(p);
+}
 
-	view_short_reg(&in," in");
-	view_short_reg(&X," X");
-	in = add_trs(X, in);
-	view_short_reg(&in,"add in");
-	in = add_trs(in, in);
-	view_short_reg(&in,"add in");
+/**
+ * Найти первую расходящуюся операцию серии от состояния lock_prev
+ */
+void lock_find(lock_engine_t fast, uint32_t steps) {
 
+	uint32_t i;
+	uint8_t ra;
+	uint8_t rb;
+	trs_t c;
+	trs_t k;
+	char *p;
+
+	memcpy(&lock_a, &lock_prev, sizeof(image_t));
+	memcpy(&lock_b, &lock_prev, sizeof(image_t));
+	for(i=0; i<steps; i++) {
+		image_to_setun(&lock_a);
+		c = C;
+		k = ld_fram(C);
+		if( (lock_step(&lock_a, fast, 1, &ra) != lock_step(&lock_b, run_reference, 1, &rb)) ||
+			(ra != rb) || (lock_cmp(&lock_a, &lock_b) != 0)
+		  ) {
+			p = dis_str(dis_buf, " --- LOCKSTEP DIVERGE opers=");
+			p = dis_int(p, (int64_t)lock_prev.opers + i, 0, 0);
+			p = dis_str(p, " C=[");
+			p = dis_trits(p, c.tb, 5);
+			p = dis_str(p, "] ");
+			p = dis_oper(p, (trishort)k.tb);
+			p = dis_str(p, " ret=");
+			p = dis_int(p, ra, 0, 0);
+			*p++ = ':';
+			p = dis_int(p, rb, 0, 0);
+			p = dis_str(p, "\n   reg\tfast\t\t\treference\n");
+			dis_flush(p);
+			lock_show(&lock_a, &lock_b);
+			return;
+		}
+		if( (ra == STOP_DONE) || (ra == STOP_OVER) || (ra == STOP_ERROR) ) {
+			break;
+		}
+	}
+	printf(" --- LOCKSTEP DIVERGE opers=%llu: not repeated by single steps\r\n",
+		   (unsigned long long)lock_prev.opers);
+	lock_show(&lock_a, &lock_b);
+}
 
-	//
-	clear(&in);
-	clear(&X);
-	in.l=5;
-	X.l=9;
-    
-	in = smtr("-----");
-    X = smtr("0000-----");
+/**
+ * Выполнить программу рабочим и эталонным циклами шаг в шаг
+ *
+ * Пар:  fast - рабочий цикл машины
+ *       steps - максимальное количество операций
+ *       every - операций между сравнениями состояний
+ * Рез:  return - количество выполненных операций
+ *       ret - статус последней операции или STOP_ERROR при расхождении
+ */
+uint32_t lock_run(lock_engine_t fast, uint32_t steps, uint32_t every, uint8_t *ret) {
 
-	view_short_reg(&in,"in=");
-	view_short_reg(&X,"X=");
+	uint32_t done;
+	uint32_t n;
+	uint32_t na;
+	uint32_t nb;
+	uint8_t ra;
+	uint8_t rb;
 
-	clean_fram();
+	if( every == 0 ) {
+		every = LOCK_EVERY;
+	}
+	image_from_setun(&lock_a);
+	memcpy(&lock_b, &lock_a, sizeof(image_t));
+
+	ra = OK;
+	done = 0;
+	while( done < steps ) {
+		n = (steps - done < every) ? steps - done : every;
+		memcpy(&lock_prev, &lock_a, sizeof(image_t));
+		na = lock_step(&lock_a, fast, n, &ra);
+		nb = lock_step(&lock_b, run_reference, n, &rb);
+		if( (na != nb) || (ra != rb) || (lock_cmp(&lock_a, &lock_b) != 0) ) {
+			lock_find(fast, n);
+			image_to_setun(&lock_a);
+			*ret = STOP_ERROR;
+			return done;
+		}
+		done += na;
+		if( (ra == STOP_DONE) || (ra == STOP_OVER) || (ra == STOP_ERROR) ) {
+			break;
+		}
+	}
 
-	in.l = 18;
-	inc_trs(&in);
-	view_short_reg(&in," m in");
-	inc_trs(&in);
-	view_short_reg(&in," m in");
+	image_to_setun(&lock_a);
+	*ret = ra;
+	return done;
+}
 
-	int l;
-	clean_fram();
-	clear(&X);
-	clear(&in);
-	X.l  = 18;
-	set_trit(&X,18,-1);
-	set_trit(&X,1,-1);
-	in = smtr("00011");
+/** *********************************************
+ *  Измерение скорости троичных операций
+ *  ---------------------------------------------
+ *
+ *  Каждая операция выполняется над BENCH_OPS случайными операндами,
+ *  время серии делится на число операций. Из BENCH_SAMPLES серий
+ *  берутся медиана и 99-й процентиль в нс на операцию.
+ *  Результат в формате CSV: make bench.
+ */
+#define BENCH_OPS		(1024)	/* операций в серии */
+#define BENCH_SAMPLES	(1001)	/* серий измерения */
 
-	st_fram(in,X);
-	set_trit(&in,1,0);
-	set_trit(&in,2,0);
-	set_trit(&in,3,0);
-	set_trit(&in,4,1);
-	set_trit(&in,5,0);
-	st_fram(in,X);
+static trs_t bench_x[BENCH_OPS];
+static trs_t bench_y[BENCH_OPS];
+static trs_t bench_a[BENCH_OPS];
+static trs_t bench_k[BENCH_OPS];
+static double bench_ns[BENCH_SAMPLES];
+static uint64_t bench_seed = 0x9E3779B97F4A7C15ull;
+volatile trilong bench_sink;	/* результат, чтобы операции не были исключены */
 
-	view_short_reg(&in," in");
-	view_short_reg(&X,"  X");
+/**
+ * Случайное число xorshift64
+ */
+uint64_t bench_rand(void) {
+	bench_seed ^= bench_seed << 13;
+	bench_seed ^= bench_seed >> 7;
+	bench_seed ^= bench_seed << 17;
+	return bench_seed;
+}
 
+/**
+ * Случайное троичное число длиной l
+ */
+trs_t bench_trs(uint8_t l) {
 
-	//t17 fram
-	printf("\nt17 --- Write/Read fram\n");
+	uint8_t i;
+	trs_t t;
 
-	clear(&X);
-	clear(&in);
-	X.l  = 18;
-	set_trit(&X,1,-1);
-	set_trit(&X,18,-1);
-	in.l = 5;
-	set_trit(&in,1,-1);
-	set_trit(&in,2,-1);
-	set_trit(&in,3,-1);
-	set_trit(&in,4,-1);
-	set_trit(&in,5,-1);
+	t.l = l;
+	t.tb = 0;
+	for(i=0; i<l; i++) {
+		t.tb = (t.tb << 2) | bit2tb((int8_t)(bench_rand() % 3) - 1);
+	}
+	return t;
+}
 
-	printf("\nst_fram(in,X)\r\n");
+/**
+ * Сравнение времени серий для qsort()
+ */
+int bench_cmp(const void *a, const void *b) {
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
 
-	for(l=-121;l<=+121;l++) { //TRIT5_MIN TRIT5_MAX
+/**
+ * Строка CSV: медиана и 99-й процентиль серий
+ */
+void bench_report(char *name) {
+	qsort(bench_ns, BENCH_SAMPLES, sizeof(double), bench_cmp);
+	printf("%s,%d,%d,%.2f,%.2f\n", name, BENCH_OPS, BENCH_SAMPLES,
+		   bench_ns[BENCH_SAMPLES / 2], bench_ns[(BENCH_SAMPLES * 99) / 100]);
+}
 
-		if( get_trit_int(in,5) == -1 ) {
-			view_short_reg(&in," addr");
-			st_fram(in,X);
-		}
-		inc_trs(&in);
-		inc_trs(&X);
-	}
-	
-	dump_fram();
+/**
+ * Серии измерения операции expr для операндов с индексом i
+ */
+#define BENCH(name, expr) { \
+	for(s=0; s<BENCH_SAMPLES; s++) { \
+		clock_gettime(CLOCK_MONOTONIC, &t0); \
+		for(i=0; i<BENCH_OPS; i++) { \
+			expr; \
+		} \
+		clock_gettime(CLOCK_MONOTONIC, &t1); \
+		bench_ns[s] = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / BENCH_OPS; \
+	} \
+	bench_report(name); \
+}
 
-	//
-	view_short_reg(&k,"in k");
-	dec_trs(&k);
-	dec_trs(&k);
-	view_short_reg(&k,"out k");
+/**
+ * Измерить троичные операции, доступ к FRAM и устройство управления
+ */
+void bench_trits(void) {
 
-	printf("\n --- VM Setun-1958 Executes --- \n");
+	uint16_t i;
+	uint16_t s;
+	struct timespec t0;
+	struct timespec t1;
 
 	reset_setun_1958();
+	for(i=0; i<BENCH_OPS; i++) {
+		bench_x[i] = bench_trs(SIZE_WORD_LONG);
+		bench_y[i] = bench_trs(SIZE_WORD_LONG);
+		bench_a[i] = bench_trs(5);
+		bench_k[i] = bench_trs(SIZE_WORD_SHORT);
+	}
 
-	clear(&k);
-	k.l = 9;
-	set_trit(&k,1,-1);
-	set_trit(&k,2,-1);
-	set_trit(&k,3,-1);
-	set_trit(&k,4,-1);
-	set_trit(&k,5,-1);
-	set_trit(&k,6,-1);
-	set_trit(&k,7,-1);
-	set_trit(&k,8,-1);
-	set_trit(&k,9,-1);
+	printf("bench,ops,samples,median_ns,p99_ns\n");
+	BENCH("add_trs",      bench_sink ^= add_trs(bench_x[i], bench_y[i]).tb);
+	BENCH("sub_trs",      bench_sink ^= sub_trs(bench_x[i], bench_y[i]).tb);
+	BENCH("xor_trs",      bench_sink ^= xor_trs(bench_x[i], bench_y[i]).tb);
+	BENCH("not_trs",      bench_sink ^= not_trs(bench_x[i]).tb);
+	BENCH("sgn_trs",      bench_sink ^= sgn_trs(bench_x[i]).tb);
+	BENCH("slice_trs",    bench_sink ^= slice_trs(bench_k[i], 1, 5).tb);
+	BENCH("trs_to_digit", bench_sink ^= trs_to_digit(&bench_x[i]));
+	BENCH("st_fram",      st_fram(bench_a[i], bench_k[i]));
+	BENCH("ld_fram",      bench_sink ^= ld_fram(bench_a[i]).tb);
+	BENCH("control_trs",  bench_sink ^= control_trs(bench_k[i]).tb);
 
-	//view_short_reg(&k," k");
-	//C = control_trs(k);
-	//view_short_reg(&C," C");
+	reset_setun_1958();
+}
 
-	//for(l=TRIT9_MIN;l<=TRIT9_MAX;l++) {
-	//	inc_trs(&k);
-	//	status = execute_trs( control_trs(k) );
-	//}
+/** *********************************************
+ *  Измерение скорости программ машины
+ *  ---------------------------------------------
+ *
+ *  Программы ur0/, ur1/ и синтетические циклы выполняются без трассы
+ *  с бюджетом операций, остановленная программа перезапускается из
+ *  эталонного образа. Результат в формате CSV: операций машины в
+ *  секунду, тактов хоста на операцию машины, наибольшая резидентная
+ *  память процесса. make bench-run.
+ */
+#define BENCH_RUN_STEPS	(10000000)	/* бюджет операций на программу */
 
-	view_short_regs();
+/**
+ * Синтетические циклы на языке ассемблера
+ */
+static const char *bench_loops[][2] = {
+	{ "loop_jmp",
+	  "\t.org %0000+\nl:\tJMP  l\n" },
+	{ "loop_arith",
+	  "\t.org %0000+\nl:\tLDS  x\n\tADD  x\n\tSUB  x\n\tAND  x\n\tLDR  x\n\tJMP  l\nx:\t.word 5\n" },
+	{ "loop_index",
+	  "\t.org %0000+\n\tLDF  z\nl:\tADDF one\n\tLDS  x, +F\n\tLDS  x, -F\n\tJMP  l\n"
+	  "z:\t.word 0\none:\t.word #00100\nx:\t.word 1\n" },
+	{ "loop_cond",
+	  "\t.org %0000+\nl:\tLDS  z\n\tJZ   m\n\tJMP  l\nm:\tLDS  x\n\tJP   l\n\tJMP  l\n"
+	  "z:\t.word 0\nx:\t.word 1\n" },
+	{ "loop_store",
+	  "\t.org %0000+\nl:\tLDS  x\n\tSTS  y\n\tSTC  y\n\tSTF  y\n\tJMP  l\nx:\t.word 7\ny:\t.word 0\n" },
+	{ "loop_drum",
+	  "\t.org %0000+\nl:\tDWR  %000+0\n\tDRD  %000++\n\tJMP  l\n" }
+};
 
-	//t
-	clean_drum();
-	clean_fram();
-	//printf(" --- DUMP MEM FRAM --- \n");
-	//dump_fram();
-	//dump_drum();
+/**
+ * Такты хоста
+ */
+static inline uint64_t bench_tsc(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
 
-	printf("\n --- TEST electrified_typewriter() --- \n");
+/**
+ * Выполнить загруженную программу steps операций и напечатать строку CSV
+ */
+void bench_measure(const char *name, uint32_t steps) {
+
+	uint32_t n;
+	uint32_t stops;
+	uint8_t ret;
+	uint64_t c0;
+	uint64_t c1;
+	double sec;
+	struct timespec t0;
+	struct timespec t1;
+	struct rusage ru;
+
+	golden_save();
+	n = 0;
+	stops = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	c0 = bench_tsc();
+	while( n < steps ) {
+		n += run_setun_1958(steps - n, &ret);
+		if( (ret == STOP_DONE) || (ret == STOP_OVER) || (ret == STOP_ERROR) ) {
+			golden_reset_dirty();
+			stops++;
+		}
+	}
+	c1 = bench_tsc();
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	getrusage(RUSAGE_SELF, &ru);
 
-	trs_t cp;
-	clear(&cp);
-	cp.l = 3;
-	set_trit(&cp,1,-1);
-	set_trit(&cp,2,-1);
-	set_trit(&cp,3,-1);
+	sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+	printf("%s,%u,%u,%.3f,%.0f,%.1f,%ld\n", name, n, stops, sec, n / sec,
+		   (double)(c1 - c0) / n, (long)ru.ru_maxrss);
+}
 
-	uint8_t cc;
+/**
+ * Отбор программ FRAM '*.txs' каталога: без зон барабана '*_drum_*'
+ */
+int bench_txs(const struct dirent *d) {
 
-	set_trit(&cp,1,1);
-	set_trit(&cp,2,1);
-	set_trit(&cp,3,0);
-	electrified_typewriter(cp,0);
+	size_t n;
 
-	set_trit(&cp,1,-1);
-	set_trit(&cp,2,-1);
-	set_trit(&cp,3,-1);
-	for(cc=0;cc<27;cc++) {
-		if( trs_to_digit(&cp) != 12 || trs_to_digit(&cp) != 11 ) {
-			electrified_typewriter(cp,0);
-		}
-		inc_trs(&cp);
-	}
+	n = strlen(d->d_name);
+	return (n > 4) && (strcmp(d->d_name + n - 4, ".txs") == 0) && (strstr(d->d_name, "_drum_") == NULL);
+}
 
-	set_trit(&cp,1,1);
-	set_trit(&cp,2,1);
-	set_trit(&cp,3,-1);
-	electrified_typewriter(cp,0);
+/**
+ * Загрузить программу FRAM path и зоны барабана каталога dir
+ * из файлов '*_drum_1w*.txs'
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t bench_load(char *dir, char *path) {
 
-	set_trit(&cp,1,-1);
-	set_trit(&cp,2,-1);
-	set_trit(&cp,3,-1);
-	for(cc=0;cc<27;cc++) {
-		if( trs_to_digit(&cp) != 12 || trs_to_digit(&cp) != 11 ) {
-			electrified_typewriter(cp,0);
+	DIR *d;
+	struct dirent *e;
+	char zpath[1024];
+	char zn[3];
+	char *z;
+	trs_t zone;
+
+	reset_setun_1958();
+	C = smtr("0000+");
+	if( load_txs_fram(path) != 0 ) {
+		return -1;
+	}
+	d = opendir(dir);
+	if( d == NULL ) {
+		return -1;
+	}
+	while( (e = readdir(d)) != NULL ) {
+		z = strstr(e->d_name, "_drum_");
+		if( (z == NULL) || (strlen(z) < 8) ) {
+			continue;
+		}
+		zn[0] = z[6];
+		zn[1] = z[7];
+		zn[2] = 0;
+		zone_str_2_trs((uint8_t *)zn, &zone);
+		snprintf(zpath, sizeof(zpath), "%s/%s", dir, e->d_name);
+		if( load_txs_drum(zpath, zone) != 0 ) {
+			closedir(d);
+			return -1;
 		}
-		inc_trs(&cp);
 	}
+	closedir(d);
+	return 0;
+}
 
-	set_trit(&cp,1,1);
-	set_trit(&cp,2,1);
-	set_trit(&cp,3,0);
-	electrified_typewriter(cp,1);
+/**
+ * Измерить программы каталогов ur0/, ur1/ и синтетические циклы
+ */
+void bench_run(uint32_t steps) {
 
-	set_trit(&cp,1,-1);
-	set_trit(&cp,2,-1);
-	set_trit(&cp,3,-1);
-	for(cc=0;cc<27;cc++) {
-		if( trs_to_digit(&cp) != 12 || trs_to_digit(&cp) != 11 ) {
-			electrified_typewriter(cp,1);
+	static char *dirs[] = { "ur0", "ur1" };
+	struct dirent **list;
+	char path[1024];
+	FILE *file;
+	uint8_t i;
+	int j;
+	int n;
+
+	trace_on = 0;
+	out_open(&out_dev[OUT_TTY0], "/dev/null");
+
+	printf("program,opers,stops,seconds,ips,host_cycles_per_op,max_rss_kb\n");
+	for(i=0; i < sizeof(dirs)/sizeof(dirs[0]); i++) {
+		n = scandir(dirs[i], &list, bench_txs, alphasort);
+		for(j=0; j<n; j++) {
+			snprintf(path, sizeof(path), "%s/%s", dirs[i], list[j]->d_name);
+			if( bench_load(dirs[i], path) == 0 ) {
+				bench_measure(path, steps);
+			}
+			free(list[j]);
+		}
+		if( n >= 0 ) {
+			free(list);
 		}
-		inc_trs(&cp);
 	}
 
-	set_trit(&cp,1,1);
-	set_trit(&cp,2,1);
-	set_trit(&cp,3,-1);
-	electrified_typewriter(cp,1);
-
-	set_trit(&cp,1,-1);
-	set_trit(&cp,2,-1);
-	set_trit(&cp,3,-1);
-	for(cc=0;cc<27;cc++) {
-		if( trs_to_digit(&cp) != 12 || trs_to_digit(&cp) != 11 ) {
-			electrified_typewriter(cp,1);
+	for(i=0; i < sizeof(bench_loops)/sizeof(bench_loops[0]); i++) {
+		reset_setun_1958();
+		C = smtr("0000+");
+		file = fmemopen((void *)bench_loops[i][1], strlen(bench_loops[i][1]), "r");
+		if( file == NULL ) {
+			continue;
 		}
-		inc_trs(&cp);
+		if( asm_file(file, (char *)bench_loops[i][0]) == 0 ) {
+			bench_measure(bench_loops[i][0], steps);
+		}
+		fclose(file);
 	}
 
-	printf("\nt15 --- inc_trs()\n");
-
-	//uint8_t cmd[20];
-	//trs_t dst;
-	//dst.l = 9;
-	//dst.tb = 0;
-	trs_t inr;
-	inr.l = 5;
-	set_trit(&inr,1,-1);
-	set_trit(&inr,2,-1);
-	set_trit(&inr,3,-1);
-	set_trit(&inr,4,-1);
-	set_trit(&inr,5,0);
+	out_close_all();
+	reset_setun_1958();
+	trace_on = 1;
+}
 
-	uint8_t mm;
-	for(mm=1;mm<=54;mm++) {
-		view_short_reg(&inr,"inr");
-		inc_trs(&inr);
-	}
+/** *********************************************
+ *  Сравнение троичных операций с эталоном
+ *  ---------------------------------------------
+ *
+ *  Эталон каждой операции вычисляется по тритам в массиве int8_t
+ *  через определения тритов sum_t(), and_t(), or_t(), xor_t().
+ *  Операнды - случайные и граничные слова длиной 1, 5, 9, 18 тритов.
+ *  Несовпадение с эталоном упрощается обнулением тритов, пока
+ *  ошибка сохраняется, и печатается один раз для операции.
+ *  Проверка выполняется потоками на всех ядрах хоста:
+ *  make fuzz, ./emu --fuzz [N], ./emu --fuzz-exhaustive.
+ */
+#define FUZZ_TRITS		(32)		/* тритов в поле trilong */
+#define FUZZ_CASES		(1000000)	/* случаев на поток */
+#define FUZZ_THREADS	(256)		/* наибольшее число потоков */
+#define FUZZ_SHORT		(19683)		/* 3^9 коротких слов */
 
-	//dump_fram();
-	//dump_fram();
-	printf("\n --- Size bytes DRUM, FRAM --- \n");
-	printf(" - mem_drum=%f\r\n", (float)(sizeof(mem_drum)) );
-	printf(" - mem_fram=%f\r\n", (float)(sizeof(mem_fram)) );
+static uint8_t fuzz_width[] = { 1, 5, 9, 18 };
 
-	trs_t zd;
-	zd.l = 4;
-	set_trit(&zd,1,1);
-	set_trit(&zd,2,1);
-	set_trit(&zd,3,1);
-	set_trit(&zd,4,1);
-	printf(" - zone_drum_to_index()=%i\r\n",zone_drum_to_index(zd) );
+/**
+ * Операция и её эталон
+ */
+typedef struct {
+	char *name;
+	trs_t (*fast)(trs_t x, trs_t y);	/* проверяемая операция	*/
+	trs_t (*ref)(trs_t x, trs_t y);		/* эталон по тритам		*/
+	uint8_t args;						/* число операндов		*/
+	atomic_uint_fast64_t cases;
+	atomic_uint_fast64_t fails;
+	atomic_flag shown;
+} fuzz_op_t;
 
-	trs_t rd;
-	rd.l = 4;
-	set_trit(&rd,1,1);
-	set_trit(&rd,2,1);
-	set_trit(&rd,3,1);
-	set_trit(&rd,4,1);
-	printf(" - row_drum_to_index()=%i\r\n",row_drum_to_index(rd) );
+/**
+ * Поток проверки
+ */
+typedef struct {
+	pthread_t id;
+	uint64_t seed;
+	uint64_t cases;		/* случайных случаев */
+	uint32_t first;		/* короткие слова x для полного перебора */
+	uint32_t step;
+} fuzz_thread_t;
+
+static pthread_mutex_t fuzz_lock = PTHREAD_MUTEX_INITIALIZER;
+uint32_t fuzz_threads = 0;	/* потоков проверки, 0 - по числу ядер */
+static trs_t fuzz_short[FUZZ_SHORT];
 
-	trs_t zr;
-	zr.l = 1;
-	set_trit(&zr,1,-1);
-	printf(" - zone_fram_to_index()=%i\r\n",zone_fram_to_index(zr) );
-	set_trit(&zr,1,0);
-	printf(" - zone_fram_to_index()=%i\r\n",zone_fram_to_index(zr) );
-	set_trit(&zr,1,1);
-	printf(" - zone_fram_to_index()=%i\r\n",zone_fram_to_index(zr) );
+/**
+ * Триты слова в массив t[0..FUZZ_TRITS-1], t[0] - младший трит
+ */
+static void fuzz_unpack(trs_t x, int8_t *t) {
+	uint8_t i;
+	for(i=0; i<FUZZ_TRITS; i++) {
+		t[i] = (i < x.l) ? tb2int((uint8_t)(x.tb >> (i*2))) : 0;
+	}
+}
 
-	trs_t rr;
-	rr.l = 4;
+/**
+ * Слово длиной l из массива тритов
+ */
+static trs_t fuzz_pack(int8_t *t, uint8_t l) {
+	trs_t r;
+	int8_t i;
 
-	set_trit(&rr,1,-1);
-	set_trit(&rr,2,-1);
-	set_trit(&rr,3,-1);
-	set_trit(&rr,4,0);
-	printf(" - row_fram_to_index()=%i\r\n",row_fram_to_index(rr) );
+	r.l = l;
+	r.tb = 0;
+	for(i=l-1; i>=0; i--) {
+		r.tb = (r.tb << 2) | bit2tb(t[i]);
+	}
+	return r;
+}
 
-	set_trit(&rr,1,0);
-	set_trit(&rr,2,0);
-	set_trit(&rr,3,0);
-	set_trit(&rr,4,0);
-	printf(" - row_fram_to_index()=%i\r\n",row_fram_to_index(rr) );
+/**
+ * Эталон сложения и вычитания: перенос по тритам через sum_t()
+ */
+static trs_t fuzz_ref_sum(trs_t x, trs_t y, int8_t sign) {
+	int8_t a[FUZZ_TRITS];
+	int8_t b[FUZZ_TRITS];
+	int8_t s[FUZZ_TRITS];
+	int8_t p0,p1;
+	uint8_t i,l;
+
+	fuzz_unpack(x,a);
+	fuzz_unpack(y,b);
+	l = (x.l >= y.l) ? x.l : y.l;
+	p0 = 0;
+	for(i=0; i<l; i++) {
+		b[i] *= sign;
+		sum_t(&a[i], &b[i], &p0, &s[i], &p1);
+		p0 = p1;
+	}
+	return fuzz_pack(s,l);
+}
 
-	set_trit(&rr,1,1);
-	set_trit(&rr,2,1);
-	set_trit(&rr,3,1);
-	set_trit(&rr,4,1);
-	printf(" - row_fram_to_index()=%i\r\n",row_fram_to_index(rr) );
+static trs_t fuzz_ref_add(trs_t x, trs_t y) {
+	return fuzz_ref_sum(x,y,1);
+}
 
+static trs_t fuzz_ref_sub(trs_t x, trs_t y) {
+	return fuzz_ref_sum(x,y,-1);
+}
 
-	printf(" - 1. \r\n");
-	trs_t aa;
-	aa.l = 5;
-	set_trit(&aa,1,-1);
-	set_trit(&aa,2,-1);
-	set_trit(&aa,3,1);
-	set_trit(&aa,4,1);
-	set_trit(&aa,5,-1);
+/**
+ * Эталон поразрядной операции f над тритами
+ */
+static trs_t fuzz_ref_bits(trs_t x, trs_t y, void (*f)(int8_t *a, int8_t *b, int8_t *s)) {
+	int8_t a[FUZZ_TRITS];
+	int8_t b[FUZZ_TRITS];
+	int8_t s[FUZZ_TRITS];
+	uint8_t i,l;
+
+	fuzz_unpack(x,a);
+	fuzz_unpack(y,b);
+	l = (x.l >= y.l) ? x.l : y.l;
+	for(i=0; i<l; i++) {
+		f(&a[i], &b[i], &s[i]);
+	}
+	return fuzz_pack(s,l);
+}
 
-	R.tb = 0;
-	set_trit(&R,1,-1);
-	set_trit(&R,18,-1);
-	view_short_reg(&R,"R");
+static trs_t fuzz_ref_and(trs_t x, trs_t y) {
+	return fuzz_ref_bits(x,y,and_t);
+}
 
-	st_fram(aa,R);
-	R = ld_fram(aa);
-	view_short_reg(&aa,"aa");
-	view_short_reg(&R,"R");
+static trs_t fuzz_ref_or(trs_t x, trs_t y) {
+	return fuzz_ref_bits(x,y,or_t);
+}
 
-	printf(" - 2. \r\n");
-	set_trit(&aa,1,-1);
-	set_trit(&aa,2,-1);
-	set_trit(&aa,3,-1);
-	set_trit(&aa,4,-1);
-	set_trit(&aa,5,-1);
+static trs_t fuzz_ref_xor(trs_t x, trs_t y) {
+	return fuzz_ref_bits(x,y,xor_t);
+}
 
-	st_fram(aa,aa);
-	R = ld_fram(aa);
-	view_short_reg(&aa,"aa");
-	view_short_reg(&R,"R");
+/**
+ * Эталон отрицания: каждый трит со сменой знака
+ */
+static trs_t fuzz_ref_not(trs_t x, trs_t y) {
+	int8_t a[FUZZ_TRITS];
+	uint8_t i;
 
-	printf(" - 3. \r\n");
-	inc_trs(&aa);
-	st_fram(aa,aa);
-	R = ld_fram(aa);
-	view_short_reg(&aa,"aa");
-	view_short_reg(&R,"R");
+	(void)y;
+	fuzz_unpack(x,a);
+	for(i=0; i<x.l; i++) {
+		a[i] = -a[i];
+	}
+	return fuzz_pack(a,x.l);
+}
 
-	printf(" - 4. \r\n");
-	inc_trs(&aa);
-	st_fram(aa,aa);
-	R = ld_fram(aa);
-	view_short_reg(&aa,"aa");
-	view_short_reg(&R,"R");
+/**
+ * Эталон знака: старший ненулевой трит в слове длиной 1
+ */
+static trs_t fuzz_ref_sgn(trs_t x, trs_t y) {
+	int8_t a[FUZZ_TRITS];
+	int8_t i;
 
-	set_trit(&aa,1,1);
-	set_trit(&aa,2,1);
-	set_trit(&aa,3,1);
-	set_trit(&aa,4,1);
-	set_trit(&aa,5,1);
-	st_fram(aa,aa);
-	R = ld_fram(aa);
-	view_short_reg(&aa,"aa");
-	view_short_reg(&R,"R");
+	(void)y;
+	fuzz_unpack(x,a);
+	for(i=x.l-1; i>0 && a[i]==0; i--) {
+	}
+	return fuzz_pack(&a[(x.l > 0) ? i : 0],1);
+}
 
-	//
-	//dump_fram();
-	//dump_drum();
+/**
+ * Одноместные операции в виде двухместных
+ */
+static trs_t fuzz_not_trs(trs_t x, trs_t y) {
+	(void)y;
+	return not_trs(x);
+}
 
-	printf("\r\n --- smtr() --- \n");
-    R = smtr("-+0+-");
-	view_short_reg(&R,"R");
+static trs_t fuzz_sgn_trs(trs_t x, trs_t y) {
+	(void)y;
+	return sgn_trs(x);
+}
 
-    R = smtr("---------");
-	view_short_reg(&R,"R");
+static fuzz_op_t fuzz_ops[] = {
+	{ "add_trs", add_trs,      fuzz_ref_add, 2, 0, 0, ATOMIC_FLAG_INIT },
+	{ "sub_trs", sub_trs,      fuzz_ref_sub, 2, 0, 0, ATOMIC_FLAG_INIT },
+	{ "and_trs", and_trs,      fuzz_ref_and, 2, 0, 0, ATOMIC_FLAG_INIT },
+	{ "or_trs",  or_trs,       fuzz_ref_or,  2, 0, 0, ATOMIC_FLAG_INIT },
+	{ "xor_trs", xor_trs,      fuzz_ref_xor, 2, 0, 0, ATOMIC_FLAG_INIT },
+	{ "not_trs", fuzz_not_trs, fuzz_ref_not, 1, 0, 0, ATOMIC_FLAG_INIT },
+	{ "sgn_trs", fuzz_sgn_trs, fuzz_ref_sgn, 1, 0, 0, ATOMIC_FLAG_INIT },
+};
+#define FUZZ_OPS	(sizeof(fuzz_ops)/sizeof(fuzz_ops[0]))
 
-    R = smtr("+++++++++");
-	view_short_reg(&R,"R");
-	
-	
-	printf("\n\nt17 --- trishort, trilong types data\n");
-	
-	static trishort ts = (trishort)1<<31;
-	static trilong  tl = (trilong)1<<63;
-	
-	printf("sizeof trishort ts=%li\r\n",sizeof(ts)); 
-	printf("sizeof trilong  tl=%li\r\n",sizeof(tl)); 
+/**
+ * Случайное число xorshift64 потока
+ */
+static inline uint64_t fuzz_rand(uint64_t *s) {
+	*s ^= *s << 13;
+	*s ^= *s >> 7;
+	*s ^= *s << 17;
+	return *s;
+}
 
-	for(uint8_t i=0;i<32;i++) {
-		printf(" tl=%016p\r\n",tl); 
-		printf(" ts=tl=%08p\r\n",ts); 
-		printf("\ntl >>= 2\n"); 
-		tl >>=2;
-		ts = tl;
-	}
+/**
+ * Случайное или граничное слово: нули, все '+', все '-',
+ * чередование '+-', один ненулевой трит, случайные триты
+ */
+static trs_t fuzz_word(uint64_t *s) {
+	trs_t t;
+	uint64_t r;
+	uint8_t i;
 
+	r = fuzz_rand(s);
+	t.l = fuzz_width[r & 3];
+	t.tb = 0;
+	r >>= 2;
+	switch( r & 7 ) {
+		case 0: break;
+		case 1: for(i=0; i<t.l; i++) { t.tb = (t.tb << 2) | 2; } break;
+		case 2: for(i=0; i<t.l; i++) { t.tb = (t.tb << 2) | 1; } break;
+		case 3: for(i=0; i<t.l; i++) { t.tb = (t.tb << 2) | (1 + (i & 1)); } break;
+		case 4: t.tb = (trilong)(1 + ((r >> 3) & 1)) << (((r >> 4) % t.l) * 2); break;
+		default:
+			r = fuzz_rand(s);
+			for(i=0; i<t.l; i++) {
+				t.tb = (t.tb << 2) | bit2tb((int8_t)(r % 3) - 1);
+				r /= 3;
+			}
+	}
+	return t;
+}
 
-	printf("\n --- STOP Triniti tests VM SETUN-1958 ---\n");
+/**
+ * Результат операции отличается от эталона
+ */
+static inline uint8_t fuzz_differ(fuzz_op_t *op, trs_t x, trs_t y) {
+	trs_t a = op->fast(x,y);
+	trs_t b = op->ref(x,y);
+	return (a.l != b.l) || (a.tb != b.tb);
 }
 
+/**
+ * Упростить несовпадение: обнулить триты, пока ошибка сохраняется
+ */
+static void fuzz_shrink(fuzz_op_t *op, trs_t *x, trs_t *y) {
+	trs_t *w[2] = { x, y };
+	trs_t t;
+	uint8_t k;
+	int8_t pos;
+
+	for(k=0; k<op->args; k++) {
+		for(pos=1; pos<=w[k]->l; pos++) {
+			if( get_trit_int(*w[k],pos) == 0 ) {
+				continue;
+			}
+			t = *w[k];
+			set_trit(w[k],pos,0);
+			if( !fuzz_differ(op,*x,*y) ) {
+				*w[k] = t;
+			}
+		}
+	}
+}
 
-/** *********************************************
- *  Тестирование виртуальной машины "Сетунь-1958"
- *  типов данных, функции
- *  ---------------------------------------------
+/**
+ * Печать упрощённого несовпадения
  */
-void Setun_test_Opers( void ) {
-	
-	trs_t exK;	
-	trs_t oper;
-	trs_t m0;
-	trs_t m1;
-	trs_t addr;
-	trs_t ad1;
-	trs_t ad2;
-	uint8_t ret_exec;
-	
-	//t__ test sub_trs
-	trs_t aaa = smtr("+++++++++000000000");
-	trs_t bbb = smtr("---------+++++++++");
-	trs_t ccc;
-	ccc = sub_trs(aaa,bbb);
-	view_short_reg(&ccc,"c=a-b");
+static void fuzz_show(fuzz_op_t *op, trs_t x, trs_t y) {
+	char buf[4][FUZZ_TRITS + 1];
+	trs_t a,b;
+
+	fuzz_shrink(op,&x,&y);
+	a = op->fast(x,y);
+	b = op->ref(x,y);
+	*dis_trits(buf[0], x.tb, x.l) = '\0';
+	*dis_trits(buf[1], y.tb, y.l) = '\0';
+	*dis_trits(buf[2], a.tb, a.l) = '\0';
+	*dis_trits(buf[3], b.tb, b.l) = '\0';
+	pthread_mutex_lock(&fuzz_lock);
+	printf(" --- MISMATCH %s: x=[%s]", op->name, buf[0]);
+	if( op->args > 1 ) {
+		printf(" y=[%s]", buf[1]);
+	}
+	printf(" fast=[%s] l=%u tb=0x%llx ref=[%s] l=%u\r\n",
+		   buf[2], a.l, (unsigned long long)a.tb, buf[3], b.l);
+	pthread_mutex_unlock(&fuzz_lock);
+}
 
-	//t18 test Oper=k6..8[+00] : (A*)=>(S)
-	printf("\nt18: test Oper=k6..8[+00] : (A*)=>(S)\n");	
-	
-	reset_setun_1958(); 
-		
-	addr = smtr("00000");
-	view_short_reg(&addr,"addr=");
-	m0 = smtr("+0-0+0-00"); 	
-	st_fram(addr,m0); 
-	view_fram(addr);		
-	
-	addr = smtr("0000+"); 
-	m1 = smtr("00000+000"); 
-	st_fram(addr,m1); 
-	view_fram(addr);		
-				
-	/* Begin address fram */ 	
-	C = smtr("0000+");	
-	
-	printf("\nreg C = 00001\n"); 
-	
-	/** 
-	* work VM Setun-1958
-	*/
+/**
+ * Проверить операцию на операндах x, y
+ */
+static inline void fuzz_case(fuzz_op_t *op, trs_t x, trs_t y) {
+	if( fuzz_differ(op,x,y) ) {
+		atomic_fetch_add_explicit(&op->fails, 1, memory_order_relaxed);
+		if( !atomic_flag_test_and_set(&op->shown) ) {
+			fuzz_show(op,x,y);
+		}
+	}
+}
 
-	K = ld_fram(C);
-	view_short_reg(&K,"K=");
-	exK = control_trs(K);	
-	oper = slice_trs(K,6,8);
-	ret_exec = execute_trs(exK,oper);
-	printf("ret_exec = %i\r\n",ret_exec);
-	printf("\n");
-	
-	view_short_regs();
+/**
+ * Поток случайных и граничных случаев
+ */
+static void * fuzz_random(void *arg) {
+	fuzz_thread_t *t = (fuzz_thread_t *)arg;
+	uint64_t n;
+	uint8_t k;
+	trs_t x,y;
+
+	for(n=0; n<t->cases; n++) {
+		x = fuzz_word(&t->seed);
+		y = fuzz_word(&t->seed);
+		for(k=0; k<FUZZ_OPS; k++) {
+			fuzz_case(&fuzz_ops[k],x,y);
+		}
+	}
+	for(k=0; k<FUZZ_OPS; k++) {
+		atomic_fetch_add_explicit(&fuzz_ops[k].cases, t->cases, memory_order_relaxed);
+	}
+	return NULL;
+}
 
-	
-	//t19 test Oper=k6..8[+00] : (A*)=>(S)
-	printf("\nt19: test Oper=k6..8[+00] : (A*)=>(S)\n");	
-	
-	reset_setun_1958(); 
+/**
+ * Поток полного перебора пар коротких слов x, y
+ */
+static void * fuzz_exhaustive(void *arg) {
+	fuzz_thread_t *t = (fuzz_thread_t *)arg;
+	uint32_t i,j;
+	uint8_t k;
+
+	for(i=t->first; i<FUZZ_SHORT; i+=t->step) {
+		for(k=0; k<FUZZ_OPS; k++) {
+			if( fuzz_ops[k].args == 1 ) {
+				fuzz_case(&fuzz_ops[k],fuzz_short[i],fuzz_short[i]);
+				atomic_fetch_add_explicit(&fuzz_ops[k].cases, 1, memory_order_relaxed);
+				continue;
+			}
+			for(j=0; j<FUZZ_SHORT; j++) {
+				fuzz_case(&fuzz_ops[k],fuzz_short[i],fuzz_short[j]);
+			}
+			atomic_fetch_add_explicit(&fuzz_ops[k].cases, FUZZ_SHORT, memory_order_relaxed);
+		}
+	}
+	return NULL;
+}
 
-	F = smtr("000++"); 	
-		
-	addr = smtr("000++");
-	view_short_reg(&addr,"addr=");
-	m0 = smtr("0++++++++"); 	
-	st_fram(addr,m0); 
+/**
+ * Проверить операции на всех ядрах хоста
+ * Параметр: cases - случаев на поток, 0 - полный перебор
+ * Возврат: 0 - совпадение с эталоном, 1 - есть ошибки
+ */
+int8_t fuzz_trits(uint64_t cases) {
+	static fuzz_thread_t th[FUZZ_THREADS];
+	struct timespec t0;
+	struct timespec t1;
+	uint64_t total;
+	uint64_t fails;
+	double sec;
+	long n;
+	long i;
+	uint32_t j;
+	uint8_t k;
+
+	n = (fuzz_threads > 0) ? (long)fuzz_threads : sysconf(_SC_NPROCESSORS_ONLN);
+	if( n < 1 ) {
+		n = 1;
+	}
+	if( n > FUZZ_THREADS ) {
+		n = FUZZ_THREADS;
+	}
 
-	addr = smtr("000--");
-	view_short_reg(&addr,"addr=");
-	m0 = smtr("0++++++++"); 	
-	st_fram(addr,m0); 
+	for(j=0; j<FUZZ_SHORT; j++) {
+		fuzz_short[j].l = SIZE_WORD_SHORT;
+		fuzz_short[j].tb = 0;
+		for(k=0, i=j; k<SIZE_WORD_SHORT; k++, i/=3) {
+			fuzz_short[j].tb |= (trilong)bit2tb((int8_t)(i % 3) - 1) << (k*2);
+		}
+	}
+	for(k=0; k<FUZZ_OPS; k++) {
+		atomic_init(&fuzz_ops[k].cases, 0);
+		atomic_init(&fuzz_ops[k].fails, 0);
+		atomic_flag_clear(&fuzz_ops[k].shown);
+	}
 
-	addr = smtr("000-0");
-	view_short_reg(&addr,"addr=");
-	m0 = smtr("0--------"); 	
-	st_fram(addr,m0); 
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(i=0; i<n; i++) {
+		th[i].seed = 0x9E3779B97F4A7C15ull * (uint64_t)(i + 1) ^ (uint64_t)t0.tv_nsec;
+		th[i].cases = cases;
+		th[i].first = (uint32_t)i;
+		th[i].step = (uint32_t)n;
+		if( pthread_create(&th[i].id, NULL, (cases > 0) ? fuzz_random : fuzz_exhaustive, &th[i]) != 0 ) {
+			printf(" --- ERROR pthread_create fuzz\r\n");
+			n = i;
+			break;
+		}
+	}
+	for(i=0; i<n; i++) {
+		pthread_join(th[i].id, NULL);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+	total = 0;
+	fails = 0;
+	printf("fuzz,cases,fails\n");
+	for(k=0; k<FUZZ_OPS; k++) {
+		printf("%s,%llu,%llu\n", fuzz_ops[k].name,
+			   (unsigned long long)fuzz_ops[k].cases, (unsigned long long)fuzz_ops[k].fails);
+		total += fuzz_ops[k].cases;
+		fails += fuzz_ops[k].fails;
+	}
+	printf("threads=%ld cases=%llu seconds=%.3f cases_per_sec=%.0f\n",
+		   n, (unsigned long long)total, sec, (sec > 0) ? total / sec : 0);
 
-	addr = smtr("00000");
-	view_short_reg(&addr,"addr=");
-	m0 = smtr("+0-0+0-00"); 	
-	st_fram(addr,m0); 
-	
-	addr = smtr("0000+"); 
-	m1 = smtr("00000+0-0"); 
-	st_fram(addr,m1); 
+	return (fails > 0) ? 1 : 0;
+}
 
-	/* Begin address fram */ 	
-	C = smtr("0000+");	
-	
-	printf("\nreg C = 00001\n"); 
-	
-	/** 
-	* work VM Setun-1958
-	*/
-	K = ld_fram(C);	
-	exK = control_trs(K);	
-	view_short_reg(&K,"K=");
-	oper = slice_trs(K,6,8);
-	ret_exec = execute_trs(exK,oper);
-	printf("ret_exec = %i\r\n",ret_exec);
-	printf("\n");
+/** -------------------------------
+ *  Main
+ *  -------------------------------
+ *
+ *  Опции обрабатываются getopt_long() по порядку: образы и программы
+ *  загружаются в момент разбора, поэтому --drum-file указывается
+ *  раньше загрузки зон, --start - после. Файл без опции загружается
+ *  по расширению: '*.s' - ассемблер, '*.img' - образ, иначе '*.txs'.
+ *  Без аргументов выполняются встроенные тесты.
+ */
+enum {
+	MODE_RUN = 0,	/* выполнение программы */
+	MODE_TEST,		/* встроенные тесты */
+	MODE_BENCH,		/* скорость троичных операций */
+	MODE_BENCH_RUN,	/* скорость программ машины */
+	MODE_FUZZ,		/* сравнение операций с эталоном */
+	MODE_FUZZ_ALL	/* полный перебор коротких слов */
+};
 
+enum {
+	OPT_TXS = 256, OPT_DRUM, OPT_IMAGE, OPT_SAVE_IMAGE, OPT_ASM, OPT_ASM_TXS,
+	OPT_RESTORE, OPT_CHECKPOINT, OPT_CHECKPOINT_EVERY, OPT_REPEAT, OPT_START,
+	OPT_DRUM_TIMING, OPT_IO_TIMING, OPT_TIMING, OPT_DRUM_FILE, OPT_DRUM_FILE_RO,
+	OPT_TRACE, OPT_NO_TRACE, OPT_DUMP_CHANGED, OPT_STATS, OPT_STATS_JSON,
+	OPT_PROFILE_FOLDED, OPT_PROFILE_DIS, OPT_VCD, OPT_VCD_WINDOW,
+	OPT_SAMPLE_PROF, OPT_SAMPLE_HZ, OPT_LATENCY, OPT_LOCKSTEP,
+	OPT_PTR0, OPT_PTR1, OPT_PTP0, OPT_LPT0, OPT_TTY0, OPT_UP0, OPT_UR0, OPT_UR1,
+	OPT_ASYNC_IO, OPT_TEST, OPT_BENCH, OPT_BENCH_RUN, OPT_FUZZ, OPT_FUZZ_ALL
+};
 
-	addr = smtr("0000+"); 
-	m1 = smtr("00000+00+"); 
-	st_fram(addr,m1); 
+static struct option main_opts[] = {
+	{ "help",             no_argument,       NULL, 'h' },
+	{ "steps",            required_argument, NULL, 'n' },
+	{ "threads",          required_argument, NULL, 'j' },
+	{ "txs",              required_argument, NULL, OPT_TXS },
+	{ "drum",             required_argument, NULL, OPT_DRUM },
+	{ "image",            required_argument, NULL, OPT_IMAGE },
+	{ "save-image",       required_argument, NULL, OPT_SAVE_IMAGE },
+	{ "asm",              required_argument, NULL, OPT_ASM },
+	{ "asm-txs",          required_argument, NULL, OPT_ASM_TXS },
+	{ "restore",          required_argument, NULL, OPT_RESTORE },
+	{ "checkpoint",       required_argument, NULL, OPT_CHECKPOINT },
+	{ "checkpoint-every", required_argument, NULL, OPT_CHECKPOINT_EVERY },
+	{ "repeat",           required_argument, NULL, OPT_REPEAT },
+	{ "start",            required_argument, NULL, OPT_START },
+	{ "drum-timing",      no_argument,       NULL, OPT_DRUM_TIMING },
+	{ "io-timing",        no_argument,       NULL, OPT_IO_TIMING },
+	{ "timing",           required_argument, NULL, OPT_TIMING },
+	{ "drum-file",        required_argument, NULL, OPT_DRUM_FILE },
+	{ "drum-file-ro",     required_argument, NULL, OPT_DRUM_FILE_RO },
+	{ "trace",            required_argument, NULL, OPT_TRACE },
+	{ "no-trace",         no_argument,       NULL, OPT_NO_TRACE },
+	{ "dump-changed",     no_argument,       NULL, OPT_DUMP_CHANGED },
+	{ "stats",            no_argument,       NULL, OPT_STATS },
+	{ "stats-json",       required_argument, NULL, OPT_STATS_JSON },
+	{ "profile-folded",   required_argument, NULL, OPT_PROFILE_FOLDED },
+	{ "profile-dis",      required_argument, NULL, OPT_PROFILE_DIS },
+	{ "vcd",              required_argument, NULL, OPT_VCD },
+	{ "vcd-window",       required_argument, NULL, OPT_VCD_WINDOW },
+	{ "sample-prof",      required_argument, NULL, OPT_SAMPLE_PROF },
+	{ "sample-hz",        required_argument, NULL, OPT_SAMPLE_HZ },
+	{ "latency",          required_argument, NULL, OPT_LATENCY },
+	{ "lockstep",         required_argument, NULL, OPT_LOCKSTEP },
+	{ "ptr0",             required_argument, NULL, OPT_PTR0 },
+	{ "ptr1",             required_argument, NULL, OPT_PTR1 },
+	{ "ptp0",             required_argument, NULL, OPT_PTP0 },
+	{ "lpt0",             required_argument, NULL, OPT_LPT0 },
+	{ "tty0",             required_argument, NULL, OPT_TTY0 },
+	{ "up0",              required_argument, NULL, OPT_UP0 },
+	{ "ur0",              required_argument, NULL, OPT_UR0 },
+	{ "ur1",              required_argument, NULL, OPT_UR1 },
+	{ "async-io",         no_argument,       NULL, OPT_ASYNC_IO },
+	{ "test",             no_argument,       NULL, OPT_TEST },
+	{ "bench",            no_argument,       NULL, OPT_BENCH },
+	{ "bench-run",        optional_argument, NULL, OPT_BENCH_RUN },
+	{ "fuzz",             optional_argument, NULL, OPT_FUZZ },
+	{ "fuzz-exhaustive",  no_argument,       NULL, OPT_FUZZ_ALL },
+	{ NULL, 0, NULL, 0 }
+};
 
-	/* Begin address fram */ 	
-	C = smtr("0000+");	
-	
-	printf("\nreg C = 00001\n"); 
-	
-	/** 
-	* work VM Setun-1958
-	*/
-	K = ld_fram(C);	
-	exK = control_trs(K);	
-	view_short_reg(&K,"K=");
-	oper = slice_trs(K,6,8);
-	ret_exec = execute_trs(exK,oper);
-	printf("ret_exec = %i\r\n",ret_exec);
-	printf("\n");
+/**
+ * Печать опций командной строки
+ */
+void usage(char *name) {
+	printf("usage: %s [options] [program.s | program.txs | machine.img ...]\r\n"
+		   " program and memory:\r\n"
+		   "  --txs file.txs  --drum zone file.txs  --image file.img  --save-image file.img\r\n"
+		   "  --asm file.s  --asm-txs file.txs  --drum-file file.drum  --drum-file-ro file.drum\r\n"
+		   "  --restore file.img  --checkpoint file.img  --checkpoint-every N\r\n"
+		   " run:\r\n"
+		   "  --start ADDR (----0..++++ or -121..121)  -n, --steps N  --repeat N  --lockstep N\r\n"
+		   "  --timing none|drum|io|all  --drum-timing  --io-timing  --trace 0|1  --no-trace\r\n"
+		   " devices:\r\n"
+		   "  --ptr0 tape.txt  --ptr1 tape.txt  --ptp0 tape.txt  --lpt0 print.txt  --tty0 typewriter.txt\r\n"
+		   "  --up0 words.txs  --ur0 tape.txs  --ur1 tape.txs  --async-io\r\n"
+		   " output:\r\n"
+		   "  --dump-changed  --stats  --stats-json file.json  --latency N\r\n"
+		   "  --profile-folded file.folded  --profile-dis file.dis  --sample-prof file.txt  --sample-hz N\r\n"
+		   "  --vcd file.vcd  --vcd-window N:M\r\n"
+		   " modes:\r\n"
+		   "  --test  --bench  --bench-run [N]  --fuzz [N]  --fuzz-exhaustive  -j, --threads N  -h, --help\r\n",
+		   name);
+}
 
-	view_short_regs();
-	
-	/* Begin address fram */ 	
-	C = smtr("000+0");	
-	printf("\nreg C = 00010\n"); 
-	
-	addr = smtr("000+0"); 
-	m1 = smtr("00000+0--"); 
-	st_fram(addr,m1); 
+/**
+ * Необязательное число опции: "--fuzz=N" или "--fuzz N"
+ */
+static char * opt_number(int argc, char *argv[]) {
+	if( optarg != NULL ) {
+		return optarg;
+	}
+	if( (optind < argc) && (argv[optind][0] >= '0') && (argv[optind][0] <= '9') ) {
+		return argv[optind++];
+	}
+	return NULL;
+}
 
-	/** 
-	* work VM Setun-1958
-	*/	
-	K = ld_fram(C);	
-	exK = control_trs(K);	
-	view_short_reg(&K,"K=");
-	oper = slice_trs(K,6,8);
-	ret_exec = execute_trs(exK,oper);
-	printf("ret_exec = %i\r\n",ret_exec);
-	printf("\n");
+/**
+ * Число опции: десятичные цифры без знака, не больше max
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t opt_uint(char *s, uint64_t max, uint64_t *v) {
 
-	ad1 = smtr("000-0");
-	ad2 = smtr("00+-0");	
-	dumpf(ad1,ad2);
+	char *e;
 
-	view_short_regs();
+	if( (s[0] < '0') || (s[0] > '9') ) {
+		return -1;
+	}
+	*v = strtoull(s, &e, 10);
+	if( (*e != 0) || (*v > max) ) {
+		return -1;
+	}
+	return 0;
+}
 
-	/* Begin address fram */ 	
-	C = smtr("000++");	
-	printf("\nreg C = 00011\n"); 
-	
-	addr = smtr("000++"); 
-	m1 = smtr("00000++00"); 
-	st_fram(addr,m1); 
+/**
+ * Зона барабана опции: две девятеричные цифры, как в '.zone'
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t opt_zone(char *s, trs_t *zone) {
 
-	/** 
-	* work VM Setun-1958
-	*/	
-	K = ld_fram(C);	
-	exK = control_trs(K);	
-	view_short_reg(&K,"K=");
-	oper = slice_trs(K,6,8);
-	ret_exec = execute_trs(exK,oper);
-	printf("ret_exec = %i\r\n",ret_exec);
-	printf("\n");
+	if( (strlen(s) != 2) || (nonary_bits[(uint8_t)s[0]] == 0) ||
+		(nonary_bits[(uint8_t)s[1]] == 0)
+	  ) {
+		return -1;
+	}
+	zone_str_2_trs((uint8_t *)s, zone);
+	if( mb_to_zone_index(*zone) < 0 ) {
+		return -1;
+	}
+	return 0;
+}
 
-	ad1 = smtr("000-0");
-	ad2 = smtr("00+-0");	
-	dumpf(ad1,ad2);
+/**
+ * Адрес начала программы: 5 тритов '-','0','+' или число -121..121
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
+ */
+int8_t opt_start(char *s, trs_t *c) {
 
-	view_short_regs();
+	char *e;
+	long v;
 
-}	
+	if( (strlen(s) == 5) && (strspn(s, "-0+") == 5) ) {
+		*c = smtr((uint8_t *)s);
+		return 0;
+	}
+	v = strtol(s, &e, 10);
+	if( (*s == '\0') || (*e != '\0') || (v < -121) || (v > 121) ) {
+		printf(" --- ERROR start address '%s'\r\n", s);
+		return -1;
+	}
+	c->l = 5;
+	c->tb = asm_int2tb((int32_t)v, 5);
+	return 0;
+}
 
-/** -------------------------------
- *  Main
- *  -------------------------------
+/**
+ * Загрузить файл программы по расширению
+ *
+ * Рез:  return=0 - OK', return|=0 - Error
  */
+int8_t opt_load(char *path) {
+
+	char *ext;
+
+	ext = strrchr(path, '.');
+	if( (ext != NULL) && (strcmp(ext, ".s") == 0) ) {
+		return asm_setun(path);
+	}
+	if( (ext != NULL) && (strcmp(ext, ".img") == 0) ) {
+		return load_image(path);
+	}
+	return load_txs_fram(path);
+}
+
 int main ( int argc, char *argv[] )
 {
-	FILE *file;
-	//trs_t k;
-	trs_t inr;
-	//addr pM;
-
-	uint8_t cmd[20]; 
-	trs_t dst;
-	
-	//trs_t sc;
-	//trs_t ka;
-	trs_t addr;
-	trs_t oper;
+	int opt;
+	trs_t zone;
+	trs_t start;
+	char *save_path;
+	char *txs_path;
+	char *stat_path;
+	char *fold_path;
+	char *pdis_path;
+	char *ckpt_path;
+	char *num;
+	uint64_t ckpt_every;
+	uint64_t cases;
+	uint32_t steps;
+	uint32_t repeat;
+	uint32_t r;
+	uint32_t lock_every;
+	uint64_t v;
+	uint8_t mode;
+	uint8_t start_set;
+	uint8_t dump_changed;
+	uint8_t stats;
+	uint32_t opers;
+	struct timespec t0;
+	struct timespec t1;
 	uint8_t ret_exec;
+	uint8_t i;
+	char *out_path[OUT_NUMBER_DEVS];
+
+	/* Сброс виртуальной машины "Сетунь-1958" */
+	reset_setun_1958();
+	C = smtr("0000+");	/* Begin address fram */
+
+	/**
+	 * Загрузить программу, зоны барабана или образ машины
+	 */
+	mode = (argc <= 1) ? MODE_TEST : MODE_RUN;
+	save_path = NULL;
+	txs_path = NULL;
+	stat_path = NULL;
+	fold_path = NULL;
+	pdis_path = NULL;
+	ckpt_path = NULL;
+	ckpt_every = 0;
+	cases = FUZZ_CASES;
+	steps = 10000;
+	repeat = 1;
+	lock_every = 0;
+	start_set = 0;
+	dump_changed = 0;
+	stats = 0;
+	memset(out_path, 0, sizeof(out_path));
+	while( (opt = getopt_long(argc, argv, "-hn:j:", main_opts, NULL)) != -1 ) {
+		switch( opt ) {
+			case 1:		/* файл программы без опции */
+				if( opt_load(optarg) != 0 ) {
+					return 1;
+				}
+				break;
+			case OPT_TXS:
+				if( load_txs_fram(optarg) != 0 ) {
+					return 1;
+				}
+				break;
+			case OPT_DRUM:
+				if( optind >= argc ) {
+					usage(argv[0]);
+					return 1;
+				}
+				if( opt_zone(optarg, &zone) != 0 ) {
+					usage(argv[0]);
+					return 1;
+				}
+				if( load_txs_drum(argv[optind++],zone) != 0 ) {
+					return 1;
+				}
+				break;
+			case OPT_IMAGE:
+				if( load_image(optarg) != 0 ) {
+					return 1;
+				}
+				break;
+			case OPT_SAVE_IMAGE:
+				save_path = optarg;
+				break;
+			case OPT_ASM:
+				if( asm_setun(optarg) != 0 ) {
+					return 1;
+				}
+				break;
+			case OPT_ASM_TXS:
+				txs_path = optarg;
+				break;
+			case OPT_RESTORE:
+				if( restore_setun_1958(optarg) != 0 ) {
+					return 1;
+				}
+				break;
+			case OPT_CHECKPOINT:
+				ckpt_path = optarg;
+				break;
+			case OPT_CHECKPOINT_EVERY:
+				if( opt_uint(optarg, UINT64_MAX, &v) != 0 ) {
+					usage(argv[0]);
+					return 1;
+				}
+				ckpt_every = v;
+				break;
+			case 'n':
+				if( opt_uint(optarg, UINT32_MAX, &v) != 0 ) {
+					usage(argv[0]);
+					return 1;
+				}
+				steps = (uint32_t)v;
+				break;
+			case OPT_REPEAT:
+				if( opt_uint(optarg, UINT32_MAX, &v) != 0 ) {
+					usage(argv[0]);
+					return 1;
+				}
+				repeat = (uint32_t)v;
+				break;
+			case OPT_LOCKSTEP:
+				if( opt_uint(optarg, UINT32_MAX, &v) != 0 ) {
+					usage(argv[0]);
+					return 1;
+				}
+				lock_every = (uint32_t)v;
+				if( lock_every == 0 ) {
+					lock_every = LOCK_EVERY;
+				}
+				break;
+			case OPT_START:
+				if( opt_start(optarg, &start) != 0 ) {
+					return 1;
+				}
+				start_set = 1;
+				break;
+			case OPT_DRUM_TIMING:
+				drum_timing = 1;
+				break;
+			case OPT_IO_TIMING:
+				io_timing = 1;
+				break;
+			case OPT_TIMING:
+				if( strcmp(optarg,"none") == 0 ) {
+					drum_timing = 0;
+					io_timing = 0;
+				}
+				else if( strcmp(optarg,"drum") == 0 ) {
+					drum_timing = 1;
+				}
+				else if( strcmp(optarg,"io") == 0 ) {
+					io_timing = 1;
+				}
+				else if( strcmp(optarg,"all") == 0 ) {
+					drum_timing = 1;
+					io_timing = 1;
+				}
+				else {
+					printf(" --- ERROR timing '%s'\r\n", optarg);
+					return 1;
+				}
+				break;
+			case OPT_DRUM_FILE:
+				if( drum_file_open(optarg, 0) != 0 ) {
+					return 1;
+				}
+				break;
+			case OPT_DRUM_FILE_RO:
+				if( drum_file_open(optarg, 1) != 0 ) {
+					return 1;
+				}
+				break;
+			case OPT_TRACE:
+				if( opt_uint(optarg, UINT64_MAX, &v) != 0 ) {
+					usage(argv[0]);
+					return 1;
+				}
+				trace_on = (v > 0) ? 1 : 0;
+				break;
+			case OPT_NO_TRACE:
+				trace_on = 0;
+				break;
+			case OPT_DUMP_CHANGED:
+				dump_changed = 1;
+				break;
+			case OPT_STATS:
+				stats = 1;
+				break;
+			case OPT_STATS_JSON:
+				stat_path = optarg;
+				break;
+			case OPT_PROFILE_FOLDED:
+				fold_path = optarg;
+				prof_on = 1;
+				break;
+			case OPT_PROFILE_DIS:
+				pdis_path = optarg;
+				prof_on = 1;
+				break;
+			case OPT_VCD:
+				if( vcd_open(optarg) != 0 ) {
+					return 1;
+				}
+				break;
+			case OPT_VCD_WINDOW: {
+				char *e;
+				e = strchr(optarg, ':');
+				if( e != NULL ) {
+					*e++ = 0;
+				}
+				if( (opt_uint(optarg, UINT64_MAX, &vcd_from) != 0) ||
+					((e != NULL) && (opt_uint(e, UINT64_MAX, &v) != 0))
+				  ) {
+					usage(argv[0]);
+					return 1;
+				}
+				vcd_to = (e != NULL) ? v : UINT64_MAX;
+			} break;
+			case OPT_SAMPLE_PROF:
+				samp_path = optarg;
+				break;
+			case OPT_SAMPLE_HZ:
+				if( opt_uint(optarg, UINT32_MAX, &v) != 0 ) {
+					usage(argv[0]);
+					return 1;
+				}
+				samp_hz = (uint32_t)v;
+				break;
+			case OPT_LATENCY:
+				if( opt_uint(optarg, UINT32_MAX, &v) != 0 ) {
+					usage(argv[0]);
+					return 1;
+				}
+				lat_every = (uint32_t)v;
+				if( lat_every == 0 ) {
+					lat_every = LAT_EVERY;
+				}
+				lat_on = 1;
+				break;
+			case OPT_PTR0:
+			case OPT_PTR1:
+				if( ptr_open(&ptr_dev[opt - OPT_PTR0], optarg) != 0 ) {
+					return 1;
+				}
+				break;
+			case OPT_PTP0:
+				out_path[OUT_PTP0] = optarg;
+				break;
+			case OPT_LPT0:
+				out_path[OUT_LPT0] = optarg;
+				break;
+			case OPT_TTY0:
+				out_path[OUT_TTY0] = optarg;
+				break;
+			case OPT_UP0:
+				if( ptr_open(&up_dev, optarg) != 0 ) {
+					return 1;
+				}
+				break;
+			case OPT_UR0:
+			case OPT_UR1:
+				if( ur_open(&ur_dev[opt - OPT_UR0], optarg) != 0 ) {
+					return 1;
+				}
+				break;
+			case OPT_ASYNC_IO:
+				if( io_async_start() != 0 ) {
+					return 1;
+				}
+				break;
+			case 'j':
+				if( opt_uint(optarg, UINT32_MAX, &v) != 0 ) {
+					usage(argv[0]);
+					return 1;
+				}
+				fuzz_threads = (uint32_t)v;
+				break;
+			case OPT_TEST:
+				mode = MODE_TEST;
+				break;
+			case OPT_BENCH:
+				mode = MODE_BENCH;
+				break;
+			case OPT_BENCH_RUN:
+				mode = MODE_BENCH_RUN;
+				num = opt_number(argc, argv);
+				steps = BENCH_RUN_STEPS;
+				if( num != NULL ) {
+					if( opt_uint(num, UINT32_MAX, &v) != 0 ) {
+						usage(argv[0]);
+						return 1;
+					}
+					steps = (uint32_t)v;
+				}
+				break;
+			case OPT_FUZZ:
+				mode = MODE_FUZZ;
+				num = opt_number(argc, argv);
+				cases = FUZZ_CASES;
+				if( num != NULL ) {
+					if( opt_uint(num, UINT64_MAX, &v) != 0 ) {
+						usage(argv[0]);
+						return 1;
+					}
+					cases = v;
+				}
+				if( cases == 0 ) {
+					cases = FUZZ_CASES;
+				}
+				break;
+			case OPT_FUZZ_ALL:
+				mode = MODE_FUZZ_ALL;
+				break;
+			case 'h':
+				usage(argv[0]);
+				return 0;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
 
+	/**
+	 * Файлы вывода подключаются после всех образов: файл
+	 * обрезается по позиции вывода образа, а не по нулевой
+	 */
+	for(i=0; i<OUT_NUMBER_DEVS; i++) {
+		if( (out_path[i] != NULL) && (out_open(&out_dev[i], out_path[i]) != 0) ) {
+			return 1;
+		}
+	}
 
+	switch( mode ) {
+		case MODE_TEST:
 #if (TRI_TEST == 1)
-	/* Выполнить тесты */
-	Triniti_tests();	
+			/* Выполнить тесты */
+			Triniti_tests();
 #endif
+			Setun_test_Opers();
+			return 0;
+		case MODE_BENCH:
+			/* Измерение скорости троичных операций */
+			bench_trits();
+			return 0;
+		case MODE_BENCH_RUN:
+			/* Измерение скорости программ машины */
+			bench_run(steps);
+			return 0;
+		case MODE_FUZZ:
+			/* Сравнение троичных операций с эталоном */
+			return fuzz_trits(cases);
+		case MODE_FUZZ_ALL:
+			/* Полный перебор пар коротких слов */
+			return fuzz_trits(0);
+	}
 
-	Setun_test_Opers();
-	
-	return 0;
-
+	printf("\r\n --- EMULATOR SETUN-1958 --- \r\n");
 
-	printf("\r\n --- EMULATOR SETUN-1958 --- \r\n");		
+	if( start_set ) {
+		C = start;
+	}
 
-	/* Сброс виртуальной машины "Сетунь-1958" */
-	printf("\r\n --- Reset Setun-1958 --- \r\n");		
-	reset_setun_1958(); 	
-	view_short_regs();
+	/* Записать ассемблированную программу в '*.txs' */
+	if( txs_path != NULL ) {
+		if( asm_save_txs(txs_path) != 0 ) {
+			return 1;
+		}
+		printf(" --- Save txs '%s' --- \r\n", txs_path);
+	}
 
+	/* Преобразовать '*.txs' в бинарный образ */
+	if( save_path != NULL ) {
+		if( save_image(save_path) != 0 ) {
+			return 1;
+		}
+		printf(" --- Save image '%s' --- \r\n", save_path);
+	}
+	if( (txs_path != NULL) || (save_path != NULL) ) {
+		drum_file_close();
+		return 0;
+	}
 
 	/**
-	 * Загрузить из файла тест-программу
+	 * Выполение программы в ферритовой памяти "Сетунь-1958"
 	 */
-	printf("\r\n --- Load 'ur0/01-test.txs' --- \r\n");		
-    inr = smtr("----0"); /* cчетчик адреса коротких слов */
-	dst.l = 9;
-	MR.l = 18;
-	file = fopen("ur0/01-test.txs", "r");
-	while (fscanf (file, "%s\r\n", cmd) != EOF) {		
-		printf("%s -> ", cmd);
-		cmd_str_2_trs(cmd,&dst);
-		view_short_reg(&inr," addr");
-		st_fram(inr,dst);
-		inr = next_address(inr);				
+	if( ckpt_path != NULL ) {
+		checkpoint_setup(ckpt_path, ckpt_every);
 	}
-	printf(" --- EOF 'test-1.txs' --- \r\n\r\n");
 
-	dump_fram(); // test Ok'
+	mem_mark();
 
-	//dump_drum(); //TODO dbg
+	if( (samp_path != NULL) && (samp_start(samp_path, samp_hz) != 0) ) {
+		return 1;
+	}
 
-	/**
-	 * Выполнить первый код "Сетунь-1958"
-	 */
 	printf("\r\n[ Start Setun-1958 ]\r\n");
 
-	/**
-	 * Выполение программы в ферритовой памяти "Сетунь-1958"
-	 */
-	
-	/* Begin address fram */ 
-	C = smtr("0000+");	    
-	printf("\nreg C = 00001\n"); 
-	
-	/** 
-	* work VM Setun-1958
-	*/
-	for(uint16_t jj=1;jj<10000;jj++) {
-		
-		K = ld_fram(C);
-		addr = control_trs(K);
-		oper = slice_trs(K,6,8);
-				
-		ret_exec = execute_trs(addr,oper);
-		
-		if( (ret_exec == STOP_DONE) ||
-			(ret_exec == STOP_OVER) ||
-			(ret_exec == STOP_ERROR) 
-		  ) {	
-			break;
-		}		
+	if( repeat > 1 ) {
+		/* Повторные запуски программы с эталонным сбросом */
+		golden_save();
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		for(r=0; r<repeat; r++) {
+			golden_reset_dirty();
+			opers = run_setun_1958(steps, &ret_exec);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t1);
 	}
+	else if( lock_every > 0 ) {
+		/* Рабочий и эталонный циклы шаг в шаг */
+		opers = lock_run(run_setun_1958, steps, lock_every, &ret_exec);
+	}
+	else {
+		opers = run_setun_1958(steps, &ret_exec);
+	}
+
 	printf("\n");
 	printf(" - ret_exec = %i\r\n",ret_exec);
-	printf(" - opers    = %d\r\n",10000);
-	
+	printf(" - opers    = %u\r\n",opers);
+	printf(" - time     = %llu us\r\n",(unsigned long long)cycles);
+	if( drum_cow ) {
+		printf(" - drum own = %d zones\r\n",
+			   __builtin_popcountll(drum_own[0]) + __builtin_popcountll(drum_own[1]));
+	}
+	if( repeat > 1 ) {
+		printf(" - runs     = %u, %.0f runs/s\r\n", repeat,
+			   repeat / ((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9));
+	}
+
+	if( dump_changed ) {
+		dump_fram_changed();
+		dump_drum_changed();
+	}
+
+	if( stats ) {
+		stat_print();
+	}
+	if( lat_on ) {
+		lat_print();
+	}
+	if( (stat_path != NULL) && (stat_json(stat_path) != 0) ) {
+		ret_exec = STOP_ERROR;
+	}
+	if( (fold_path != NULL) && (prof_folded(fold_path) != 0) ) {
+		ret_exec = STOP_ERROR;
+	}
+	if( (pdis_path != NULL) && (prof_dis(pdis_path) != 0) ) {
+		ret_exec = STOP_ERROR;
+	}
+
 	printf("\r\n[ Stop Setun-1958 ]\r\n");
 
+	io_drain();
+	out_close_all();
+	vcd_close();
+	drum_file_close();
+	/* Статус для скриптов: аварийный останов или переполнение */
+	if( (ret_exec == STOP_ERROR) || (ret_exec == STOP_OVER) ) {
+		return 1;
+	}
+	return 0;
+
 } /* 'main.c' */
 
 /* EOF 'setun_core.c' */